@@ -0,0 +1,111 @@
+#ifndef __BENCH_HH__
+#define __BENCH_HH__
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "gabp/dynmatrix.hh"
+#include "gabp/sparse.hh"
+
+/*
+ * Problems and timing shared by the benchmarks.
+ */
+
+/**
+ * @brief Options of poisson_grid().
+ */
+struct grid_options {
+    /**
+    * @brief Added to 4 on the diagonal; smaller shifts converge more slowly.
+    */
+    double shift = 0.5;
+
+    /**
+    * @brief Side of a square at the top left corner whose diagonal uses corner_shift instead; 0 for none.
+    */
+    size_t corner = 0;
+
+    /**
+    * @brief Diagonal shift inside the corner.
+    */
+    double corner_shift = 0;
+
+    /**
+    * @brief If nonzero, seeds a random numbering of the variables instead of the row-major one.
+    */
+    unsigned scramble = 0;
+};
+
+/**
+ * @brief 5-point Laplacian of a side*side grid plus a diagonal shift.
+ */
+inline gmat::sparse_matrix<double> poisson_grid(size_t side, const grid_options& opts = grid_options())
+{
+    size_t n = side * side;
+    std::vector<size_t> label(n);
+    for (size_t i = 0; i < n; ++i) {
+        label[i] = i;
+    }
+    if (opts.scramble) {
+        std::shuffle(label.begin(), label.end(), std::mt19937(opts.scramble));
+    }
+    gmat::coo_builder<double> coo(n, n);
+    coo.reserve(5 * n);
+    for (size_t y = 0; y < side; ++y) {
+        for (size_t x = 0; x < side; ++x) {
+            size_t i = label[y * side + x];
+            bool weak = x < opts.corner && y < opts.corner;
+            coo.add(i, i, 4.0 + (weak ? opts.corner_shift : opts.shift));
+            if (x > 0) {
+                coo.add(i, label[y * side + x - 1], -1.0);
+            }
+            if (x + 1 < side) {
+                coo.add(i, label[y * side + x + 1], -1.0);
+            }
+            if (y > 0) {
+                coo.add(i, label[(y - 1) * side + x], -1.0);
+            }
+            if (y + 1 < side) {
+                coo.add(i, label[(y + 1) * side + x], -1.0);
+            }
+        }
+    }
+    return coo.build();
+}
+
+/**
+ * @brief Deterministic right-hand side.
+ */
+inline gmat::dynmatrix<double> bench_rhs(size_t n)
+{
+    gmat::dynmatrix<double> b(n, 1);
+    for (size_t i = 0; i < n; ++i) {
+        b[i] = double(i % 11) - 5.0;
+    }
+    return b;
+}
+
+/**
+ * @brief Mean time of one call to f, doubling the repetitions until they take at least min_seconds.
+ */
+template <typename F>
+double time_per_call(F&& f, double min_seconds = 0.2)
+{
+    typedef std::chrono::steady_clock clock;
+    size_t reps = 1;
+    for (;;) {
+        auto start = clock::now();
+        for (size_t r = 0; r < reps; ++r) {
+            f();
+        }
+        double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        if (elapsed > min_seconds) {
+            return elapsed / reps;
+        }
+        reps *= 2;
+    }
+}
+
+#endif // __BENCH_HH__
@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "gabp/block_solver.hh"
+#include "gabp/factor_graph.hh"
+
+/*
+ * Latency of keeping a growing SLAM-like pose graph solved. Each step adds
+ * a 3-dof pose, an odometry factor to the previous pose and, every few
+ * poses, a loop closure to an older one. The factor graph re-converges
+ * from the touched poses only; at checkpoints the same system is solved
+ * from scratch with the block solver for comparison.
+ *
+ * Usage: gabp-bench-factor-graph [poses] [closure interval] [checkpoints]
+ */
+
+typedef gabp::factor_graph<double, 3> graph_type;
+typedef graph_type::block_type block;
+typedef graph_type::vector_type vec;
+
+static size_t connect(graph_type& g, size_t i, size_t j)
+{
+    block ii(0.0), jj(0.0), ij;
+    for (size_t r = 0; r < 3; ++r) {
+        ii.set(r, r, 2.0);
+        jj.set(r, r, 2.0);
+        for (size_t k = 0; k < 3; ++k) {
+            ij.set(r, k, -0.3 / double(1 + r + 2 * k) - 0.05 * double((i + j) % 3));
+        }
+    }
+    return g.add_factor(i, j, ii, ij, jj);
+}
+
+static size_t add_pose(graph_type& g, size_t v)
+{
+    block p(0.0);
+    vec h;
+    for (size_t r = 0; r < 3; ++r) {
+        p.set(r, r, 1.0 + 0.5 * double((v + r) % 3));
+        h.set(r, 0, double((v * 7 + r * 3) % 11) - 5.0);
+    }
+    return g.add_variable(p, h);
+}
+
+static double median(std::vector<double> v)
+{
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+}
+
+int main(int argc, char** argv)
+{
+    size_t poses = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    size_t closure = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10;
+    size_t checkpoints = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 4;
+
+    gabp::options<double> opts;
+    opts.tolerance = 1e-8;
+    opts.max_iterations = 1000;
+    graph_type g(opts);
+
+    std::printf("pose graph, 3-dof poses, loop closure every %zu poses, tolerance 1e-8\n", closure);
+    std::printf("%8s %8s %16s %16s %14s %16s %14s\n", "poses", "factors", "incr median us", "incr max us",
+                "incr messages", "full solve us", "full messages");
+    std::vector<double> times;
+    size_t messages = 0;
+    size_t next_checkpoint = poses / checkpoints;
+    for (size_t v = 0; v < poses; ++v) {
+        auto start = std::chrono::steady_clock::now();
+        add_pose(g, v);
+        size_t added = 0;
+        if (v > 0) {
+            connect(g, v - 1, v);
+            ++added;
+        }
+        if (v >= 5 * closure && v % closure == 0) {
+            connect(g, v, v - 5 * closure + v % 7);
+            ++added;
+        }
+        g.propagate();
+        double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (added > 0) {
+            times.push_back(t / double(added));
+        }
+        messages += g.updates();
+
+        if (v + 1 == next_checkpoint) {
+            next_checkpoint += poses / checkpoints;
+            auto a = g.matrix();
+            auto b = g.rhs();
+            gabp::block_solver<double, 3> s(a, opts);
+            auto full_start = std::chrono::steady_clock::now();
+            s.solve(b);
+            double full = std::chrono::duration<double>(std::chrono::steady_clock::now() - full_start).count();
+            std::printf("%8zu %8zu %16.2f %16.2f %14zu %16.0f %14zu\n", g.variables(), g.factors(),
+                        median(times) * 1e6, *std::max_element(times.begin(), times.end()) * 1e6,
+                        messages / times.size(), full * 1e6, s.updates());
+            times.clear();
+            messages = 0;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include <cstdio>
+#include <memory>
+#include <utility>
+#include "gabp/matrix.hh"
+#include "bench.hh"
+
+/*
+ * Compares gmat::matmul against the plain i-j-k loop it replaced, for
+ * square float and double matrices from 2x2 to 512x512.
+ */
+
+template <typename T, size_t s>
+static void naive_matmul(const gmat::basematrix<T, s, s>& a, const gmat::basematrix<T, s, s>& b, gmat::basematrix<T, s, s>& c)
+{
+    for (size_t i = 0; i < s; ++i) {
+        for (size_t j = 0; j < s; ++j) {
+            T acc = 0;
+            for (size_t k = 0; k < s; ++k) {
+                acc += a.get(i, k) * b.get(k, j);
+            }
+            c.set(i, j, acc);
+        }
+    }
+}
+
+template <typename T, size_t s>
+static void run(const char* type)
+{
+    auto a = std::make_unique<gmat::basematrix<T, s, s>>();
+    auto b = std::make_unique<gmat::basematrix<T, s, s>>();
+    auto c = std::make_unique<gmat::basematrix<T, s, s>>();
+    for (size_t i = 0; i < s; ++i) {
+        for (size_t j = 0; j < s; ++j) {
+            a->set(i, j, T(i + 2 * j) / T(s));
+            b->set(i, j, T(2 * i + j) / T(s));
+        }
+    }
+    double naive = time_per_call([&] {
+        naive_matmul(*a, *b, *c);
+        asm volatile("" : : "r"(c->data()) : "memory");
+    });
+    double kernel = time_per_call([&] {
+        gmat::matmul(*a, *b, *c);
+        asm volatile("" : : "r"(c->data()) : "memory");
+    });
+    double flops = 2.0 * s * s * s;
+    std::printf("%-6s %4zux%-4zu %12.1f ns %8.2f GFLOP/s %12.1f ns %8.2f GFLOP/s %7.2fx\n",
+                type, s, s, naive * 1e9, flops / naive * 1e-9, kernel * 1e9, flops / kernel * 1e-9, naive / kernel);
+}
+
+template <typename T, size_t... sizes>
+static void run_all(const char* type, std::index_sequence<sizes...>)
+{
+    (run<T, sizes>(type), ...);
+}
+
+int main()
+{
+    std::printf("%-6s %9s %15s %16s %15s %16s %8s\n", "type", "size", "naive", "", "gmat::matmul", "", "speedup");
+    run_all<double>("double", std::index_sequence<2, 3, 4, 6, 8, 16, 32, 64, 128, 256, 512>());
+    run_all<float>("float", std::index_sequence<2, 3, 4, 6, 8, 16, 32, 64, 128, 256, 512>());
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "gabp/pcg.hh"
+#include "bench.hh"
+
+/*
+ * Iterations and time to tolerance of conjugate gradients with several
+ * preconditioners, and of plain GaBP, on a 2D Poisson grid whose
+ * diagonal shift sets the conditioning.
+ *
+ * Usage: gabp-bench-pcg [side] [shift] [block]
+ */
+
+static double since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename P>
+static void run(const char* name, const gmat::sparse_matrix<double>& a, const gmat::dynmatrix<double>& b,
+                const gabp::options<double>& opts, P& precond, double setup)
+{
+    gabp::pcg<double> cg(a, opts);
+    bool failed = cg.solve(b, precond);
+    std::printf("%-16s %10s %10zu %12.1f %12.1f %12.1f\n", name, failed ? "no" : "yes", cg.iterations(),
+                setup * 1e3, cg.seconds() * 1e3, (setup + cg.seconds()) * 1e3);
+}
+
+int main(int argc, char** argv)
+{
+    size_t side = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 300;
+    double shift = argc > 2 ? std::strtod(argv[2], nullptr) : 0.001;
+    size_t block = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 32;
+
+    grid_options grid;
+    grid.shift = shift;
+    auto a = poisson_grid(side, grid);
+    auto b = bench_rhs(a.rows());
+    gabp::options<double> opts;
+    opts.tolerance = 1e-8;
+    opts.max_iterations = 100000;
+
+    std::printf("grid %zux%zu, diagonal 4 + %g, relative residual 1e-8\n", side, side, shift);
+    std::printf("%-16s %10s %10s %12s %12s %12s\n", "method", "converged", "iterations", "setup ms", "solve ms", "total ms");
+
+    {
+        gabp::identity_preconditioner<double> p;
+        run("cg", a, b, opts, p, 0.0);
+    }
+    {
+        auto start = std::chrono::steady_clock::now();
+        gabp::jacobi_preconditioner<double> p(a);
+        run("pcg jacobi", a, b, opts, p, since(start));
+    }
+    {
+        auto start = std::chrono::steady_clock::now();
+        gabp::block_jacobi_preconditioner<double> p(a, block);
+        char name[32];
+        std::snprintf(name, sizeof(name), "pcg block %zu", block);
+        run(name, a, b, opts, p, since(start));
+    }
+    for (size_t sweeps : { 0, 2, 4, 8 }) {
+        auto start = std::chrono::steady_clock::now();
+        gabp::gabp_preconditioner<double> p(a, sweeps, opts);
+        char name[32];
+        std::snprintf(name, sizeof(name), "pcg gabp %zu", sweeps);
+        run(name, a, b, opts, p, since(start));
+    }
+    {
+        gabp::solver<double> s(a, opts);
+        auto start = std::chrono::steady_clock::now();
+        bool failed = s.solve(b);
+        double t = since(start);
+        std::printf("%-16s %10s %10zu %12.1f %12.1f %12.1f\n", "gabp", failed ? "no" : "yes", s.iterations(),
+                    0.0, t * 1e3, t * 1e3);
+    }
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "gabp/solver.hh"
+#include "bench.hh"
+
+/*
+ * Time to tolerance of synchronous GaBP with and without extrapolation of
+ * the h messages, on a 2D Poisson grid whose diagonal shift controls how
+ * slowly plain sweeps converge.
+ *
+ * Usage: gabp-bench-solver-acceleration [side] [shift] [window] [interval]
+ */
+
+int main(int argc, char** argv)
+{
+    size_t side = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+    double shift = argc > 2 ? std::strtod(argv[2], nullptr) : 0.01;
+    size_t window = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 5;
+    size_t interval = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 4;
+
+    grid_options grid;
+    grid.shift = shift;
+    auto a = poisson_grid(side, grid);
+    auto b = bench_rhs(a.rows());
+
+    std::printf("grid %zux%zu, diagonal 4 + %g, tolerance 1e-8, window %zu, interval %zu\n",
+                side, side, shift, window, interval);
+    std::printf("%-10s %10s %10s %12s\n", "method", "converged", "sweeps", "ms");
+    for (gabp::acceleration how : { gabp::acceleration::none, gabp::acceleration::aitken, gabp::acceleration::anderson }) {
+        gabp::options<double> opts;
+        opts.tolerance = 1e-8;
+        opts.max_iterations = 100000;
+        opts.accelerate = how;
+        opts.acceleration_window = window;
+        opts.acceleration_interval = interval;
+        gabp::solver<double> s(a, opts);
+        auto start = std::chrono::steady_clock::now();
+        bool failed = s.solve(b);
+        double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const char* name = how == gabp::acceleration::none ? "none" : how == gabp::acceleration::aitken ? "aitken" : "anderson";
+        std::printf("%-10s %10s %10zu %12.1f\n", name, failed ? "no" : "yes", s.iterations(), t * 1e3);
+    }
+    return 0;
+}
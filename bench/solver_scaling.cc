@@ -0,0 +1,57 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "gabp/solver.hh"
+#include "bench.hh"
+
+/*
+ * Strong scaling of the multi-threaded synchronous GaBP sweep on a 2D
+ * Poisson grid, from 1 thread up to the hardware thread count.
+ *
+ * Usage: gabp-bench-solver-scaling [side] [max threads] [sweeps]
+ */
+
+int main(int argc, char** argv)
+{
+    size_t side = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+    size_t max_threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : gabp::detail::thread_count(0);
+    size_t sweeps = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 20;
+
+    auto a = poisson_grid(side);
+    auto b = bench_rhs(a.rows());
+
+    std::vector<size_t> counts;
+    for (size_t t = 1; t < max_threads; t *= 2) {
+        counts.push_back(t);
+    }
+    counts.push_back(max_threads);
+
+    std::printf("grid %zux%zu, %zu variables, %zu entries, %zu sweeps\n", side, side, a.rows(), a.nnz(), sweeps);
+    std::printf("%8s %14s %16s %9s %11s\n", "threads", "ms/sweep", "Mmsg/s", "speedup", "efficiency");
+    double base = 0;
+    for (size_t threads : counts) {
+        gabp::options<double> opts;
+        opts.tolerance = 0;
+        opts.max_iterations = sweeps;
+        opts.threads = threads;
+        gabp::solver<double> s(a, opts);
+        double best = 0;
+        for (int rep = 0; rep < 3; ++rep) {
+            s.reset();
+            auto start = std::chrono::steady_clock::now();
+            s.solve(b);
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            best = rep == 0 ? elapsed : std::min(best, elapsed);
+        }
+        double per_sweep = best / double(s.iterations());
+        if (threads == 1) {
+            base = per_sweep;
+        }
+        std::printf("%8zu %14.3f %16.1f %8.2fx %10.0f%%\n", threads, per_sweep * 1e3,
+                    double(s.updates()) / best * 1e-6, base / per_sweep, 100.0 * base / per_sweep / double(threads));
+    }
+    return 0;
+}
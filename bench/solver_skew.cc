@@ -0,0 +1,60 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "gabp/solver.hh"
+#include "bench.hh"
+
+/*
+ * Solve latency of the synchronous and work-stealing schedules on a 2D
+ * Poisson grid whose convergence is skewed: a corner with a weak diagonal
+ * needs many more updates than the rest of the grid.
+ *
+ * Usage: gabp-bench-solver-skew [side] [max threads] [solves]
+ */
+
+int main(int argc, char** argv)
+{
+    size_t side = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 300;
+    size_t max_threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : gabp::detail::thread_count(0);
+    size_t solves = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 9;
+
+    grid_options grid;
+    grid.shift = 2.0;
+    grid.corner = side / 4;
+    grid.corner_shift = 0.02;
+    auto a = poisson_grid(side, grid);
+    auto b = bench_rhs(a.rows());
+
+    std::vector<size_t> counts;
+    for (size_t t = 1; t < max_threads; t *= 2) {
+        counts.push_back(t);
+    }
+    counts.push_back(max_threads);
+
+    std::printf("skewed grid %zux%zu, tolerance 1e-8, %zu solves each\n", side, side, solves);
+    std::printf("%-14s %8s %12s %12s %14s\n", "schedule", "threads", "median ms", "max ms", "messages");
+    for (gabp::schedule policy : {gabp::schedule::synchronous, gabp::schedule::work_stealing}) {
+        for (size_t threads : counts) {
+            gabp::options<double> opts;
+            opts.tolerance = 1e-8;
+            opts.max_iterations = 100000;
+            opts.policy = policy;
+            opts.threads = threads;
+            gabp::solver<double> s(a, opts);
+            std::vector<double> times;
+            for (size_t rep = 0; rep < solves; ++rep) {
+                s.reset();
+                auto start = std::chrono::steady_clock::now();
+                s.solve(b);
+                times.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+            }
+            std::sort(times.begin(), times.end());
+            std::printf("%-14s %8zu %12.2f %12.2f %14zu\n",
+                        policy == gabp::schedule::synchronous ? "synchronous" : "work_stealing",
+                        threads, times[times.size() / 2] * 1e3, times.back() * 1e3, s.updates());
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include <cstdio>
+#include <memory>
+#include <utility>
+#include "gabp/matrix.hh"
+#include "bench.hh"
+
+/*
+ * Times extracting square blocks from a 500x500 double matrix behind the
+ * type-erased interface, as block GaBP does with the precision matrix:
+ * the element-by-element copy with modulo the basematrix constructor
+ * used to make, against the bulk row copies of gmat::assign, for a
+ * window inside the matrix and one that wraps at the bottom right corner.
+ */
+
+static const size_t size = 500;
+
+typedef gmat::matrix<double, size, size> parent_type;
+
+template <size_t b>
+static void naive_extract(const parent_type& parent, size_t oi, size_t oj, gmat::basematrix<double, b, b>& dest)
+{
+    for (size_t i = 0; i < b; ++i) {
+        for (size_t j = 0; j < b; ++j) {
+            dest.set(i, j, parent.get((i + oi) % size, (j + oj) % size));
+        }
+    }
+}
+
+template <size_t b>
+static void run(const std::shared_ptr<parent_type>& parent, const char* where, size_t oi, size_t oj)
+{
+    auto dest = std::make_unique<gmat::basematrix<double, b, b>>();
+    double naive = time_per_call([&] {
+        naive_extract(*parent, oi, oj, *dest);
+        asm volatile("" : : "r"(dest->data()) : "memory");
+    });
+    gmat::submatrix<double, b, b, size, size> sub(parent, oi, oj);
+    double bulk = time_per_call([&] {
+        gmat::assign(*dest, sub);
+        asm volatile("" : : "r"(dest->data()) : "memory");
+    });
+    double bytes = sizeof(double) * b * b;
+    std::printf("%4zux%-4zu %-7s %12.1f ns %12.1f ns %8.2f GB/s %7.2fx\n",
+                b, b, where, naive * 1e9, bulk * 1e9, bytes / bulk * 1e-9, naive / bulk);
+}
+
+template <size_t... sizes>
+static void run_all(const std::shared_ptr<parent_type>& parent, std::index_sequence<sizes...>)
+{
+    (run<sizes>(parent, "inside", 100, 200), ...);
+    (run<sizes>(parent, "wraps", size - sizes / 2, size - sizes / 3), ...);
+}
+
+// Out of line, so that accesses cannot be devirtualized as they could not be in a solver.
+__attribute__((noinline)) static std::shared_ptr<parent_type> make_parent()
+{
+    return std::make_shared<gmat::erased<gmat::basematrix<double, size, size>>>();
+}
+
+int main()
+{
+    std::shared_ptr<parent_type> parent = make_parent();
+    for (size_t i = 0; i < size; ++i) {
+        for (size_t j = 0; j < size; ++j) {
+            parent->set(i, j, double(i) - double(j) / size);
+        }
+    }
+    std::printf("%9s %-7s %15s %15s %11s %8s\n", "block", "window", "element-wise", "gmat::assign", "", "speedup");
+    run_all(parent, std::index_sequence<3, 6, 16, 64, 256>());
+    return 0;
+}
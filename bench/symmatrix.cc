@@ -0,0 +1,91 @@
+#include <cstdio>
+#include <vector>
+#include "gabp/symmatrix.hh"
+#include "bench.hh"
+
+/*
+ * Times the precision block operations of block GaBP on dense basematrix
+ * blocks against packed symmatrix blocks, over a pool of blocks too large
+ * for cache, as the message pools of a large graph are: Cholesky
+ * factorization, the rank-d update forming a message from Y = U^-T A,
+ * and the symmetric matrix-vector product.
+ */
+
+static const size_t pool = 1 << 18;
+
+template <typename F>
+static double time_per_block(F&& f)
+{
+    return time_per_call(f, 0.3) / pool;
+}
+
+template <size_t d>
+static void run()
+{
+    typedef gmat::basematrix<double, d, d> dense_type;
+    typedef gmat::symmatrix<double, d> packed_type;
+    dense_type spd;
+    for (size_t i = 0; i < d; ++i) {
+        for (size_t j = 0; j < d; ++j) {
+            spd.set(i, j, i == j ? double(d + 2) : 1.0 / double(1 + i + j));
+        }
+    }
+    std::vector<dense_type> dense(pool, spd);
+    std::vector<packed_type> packed(pool, packed_type(spd));
+    gmat::basematrix<double, d, 1> x(1.0), y(0.0);
+    double sink = 0;
+
+    double dense_chol = time_per_block([&] {
+        for (dense_type& b : dense) {
+            dense_type l = b;
+            gmat::cholesky(l);
+            sink += l.get(d - 1, d - 1);
+        }
+    });
+    double packed_chol = time_per_block([&] {
+        for (packed_type& b : packed) {
+            packed_type u = b;
+            gmat::cholesky(u);
+            sink += u.get(d - 1, d - 1);
+        }
+    });
+    double dense_update = time_per_block([&] {
+        for (dense_type& b : dense) {
+            gmat::gemm(-1.0, gmat::transpose(spd), spd, 0.0, b);
+        }
+    });
+    double packed_update = time_per_block([&] {
+        for (packed_type& b : packed) {
+            gmat::syrk(-1.0, spd, 0.0, b);
+        }
+    });
+    double dense_mv = time_per_block([&] {
+        for (dense_type& b : dense) {
+            gmat::gemm(1.0, b, x, 1.0, y);
+        }
+    });
+    double packed_mv = time_per_block([&] {
+        for (packed_type& b : packed) {
+            gmat::symv(1.0, b, x, 1.0, y);
+        }
+    });
+    sink += y.get(0, 0);
+
+    std::printf("%2zux%-2zu %6zu B %6zu B  %-9s %9.1f ns %9.1f ns %7.2fx\n", d, d, sizeof(dense_type), sizeof(packed_type),
+                "cholesky", dense_chol * 1e9, packed_chol * 1e9, dense_chol / packed_chol);
+    std::printf("%23s %-9s %9.1f ns %9.1f ns %7.2fx\n", "", "rank-d", dense_update * 1e9, packed_update * 1e9,
+                dense_update / packed_update);
+    std::printf("%23s %-9s %9.1f ns %9.1f ns %7.2fx\n", "", "matvec", dense_mv * 1e9, packed_mv * 1e9, dense_mv / packed_mv);
+    if (sink == 0.5) {
+        std::printf("\n");
+    }
+}
+
+int main()
+{
+    std::printf("%5s %8s %8s  %-9s %12s %12s %8s\n", "block", "dense", "packed", "op", "dense", "packed", "speedup");
+    run<3>();
+    run<6>();
+    run<12>();
+    return 0;
+}
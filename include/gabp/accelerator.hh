@@ -0,0 +1,346 @@
+#ifndef __ACCELERATOR_HH__
+#define __ACCELERATOR_HH__
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "gabp/dynmatrix.hh"
+
+namespace gabp {
+    /**
+    * @brief Extrapolation applied to a fixed-point iteration by an %accelerator.
+    */
+    enum class acceleration {
+        /**
+        * @brief Plain iteration.
+        */
+        none,
+
+        /**
+        * @brief Vector Aitken delta-squared: from three consecutive iterates,
+        *        steps along the last difference to where the iteration
+        *        would go if it contracted at a constant rate.
+        */
+        aitken,
+
+        /**
+        * @brief Anderson mixing: combines the last window iterates with the
+        *        weights that minimize the norm of their combined residual.
+        */
+        anderson
+    };
+
+    namespace detail {
+        /**
+        * @brief Dot product with four partial sums.
+        *
+        * Breaks the dependency chain of a single accumulator, which would
+        * otherwise bound the loop by the latency of one addition per element.
+        */
+        template <typename T>
+        T dot(const T* a, const T* b, size_t n)
+        {
+            T s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+            size_t k = 0;
+            for (; k + 4 <= n; k += 4) {
+                s0 += a[k] * b[k];
+                s1 += a[k + 1] * b[k + 1];
+                s2 += a[k + 2] * b[k + 2];
+                s3 += a[k + 3] * b[k + 3];
+            }
+            for (; k < n; ++k) {
+                s0 += a[k] * b[k];
+            }
+            return (s0 + s1) + (s2 + s3);
+        }
+
+        /**
+        * @brief Writes f = x - y and returns max |f|, with four partial maxima as in dot().
+        */
+        template <typename T>
+        T difference(const T* x, const T* y, T* f, size_t n)
+        {
+            T m0 = 0, m1 = 0, m2 = 0, m3 = 0;
+            size_t k = 0;
+            for (; k + 4 <= n; k += 4) {
+                f[k] = x[k] - y[k];
+                f[k + 1] = x[k + 1] - y[k + 1];
+                f[k + 2] = x[k + 2] - y[k + 2];
+                f[k + 3] = x[k + 3] - y[k + 3];
+                m0 = std::max(m0, std::abs(f[k]));
+                m1 = std::max(m1, std::abs(f[k + 1]));
+                m2 = std::max(m2, std::abs(f[k + 2]));
+                m3 = std::max(m3, std::abs(f[k + 3]));
+            }
+            for (; k < n; ++k) {
+                f[k] = x[k] - y[k];
+                m0 = std::max(m0, std::abs(f[k]));
+            }
+            return std::max(std::max(m0, m1), std::max(m2, m3));
+        }
+    }
+
+    /**
+    * @brief Accelerates a fixed-point iteration x <- g(x) on a contiguous array.
+    * @tparam T Floating point type of elements.
+    *
+    * Call apply() after every plain step with the array holding g(x). Only
+    * every interval-th call does any work: the method runs on the
+    * iteration G = g^interval, whose steps are the arrays seen at those
+    * calls, and may overwrite the array with an extrapolated iterate to
+    * continue from. Each such call costs a few passes over the array plus
+    * one per Anderson window entry, so on cheap iterations such as scalar
+    * GaBP sweeps an interval of several steps keeps the overhead small.
+    * The residual of a step is max |G(x) - x|, which the %accelerator
+    * measures itself against the array it last handed out.
+    *
+    * Safeguard: an extrapolation is kept only if the step of G taken from
+    * it has a residual no larger than the step before it. Otherwise the
+    * array is reset to the plain iterate the extrapolation replaced, the
+    * history is dropped, and the steps taken from the extrapolation are
+    * wasted.
+    *
+    * For GaBP the array is the h messages: once the precision messages
+    * settle, the h update is linear, which is where both methods work best.
+    */
+    template <typename T>
+    class accelerator {
+    public:
+        /**
+        * @param kind Extrapolation method.
+        * @param size Number of elements of the iterated array.
+        * @param window Number of past steps Anderson mixing combines, at least 1.
+        * @param interval Number of plain steps per step of G, at least 1.
+        *                 Anderson extrapolates after every step of G once
+        *                 it has a history; Aitken after every second, as it
+        *                 needs two chained steps.
+        */
+        accelerator(acceleration kind, size_t size, size_t window = 5, size_t interval = 1)
+            : m_kind(kind), m_size(size), m_window(std::max<size_t>(window, 1)),
+              m_interval(std::max<size_t>(interval, 1)), m_input(size, T(0)), m_f(size), m_f_prev(size),
+              m_g_prev(size), m_backup(size), m_guard(0), m_delta_f(m_window, std::vector<T>(size)),
+              m_delta_g(m_window, std::vector<T>(size)), m_gram(m_window * m_window, T(0))
+        {
+            restart();
+            m_guarded = false;
+            m_extrapolations = 0;
+            m_rejected = 0;
+        }
+
+        /**
+        * @brief Sets the array the next step starts from; needed unless it starts from zero.
+        */
+        void start(const T* x)
+        {
+            std::copy_n(x, m_size, m_input.data());
+            restart();
+            m_guarded = false;
+        }
+
+        /**
+        * @brief Records one plain step and extrapolates when due.
+        * @param x The step g(x) of the array last handed out, or of the
+        *          previous step; overwritten with the array to continue from.
+        * @return true if x was changed.
+        */
+        bool apply(T* x)
+        {
+            if (m_kind == acceleration::none || ++m_count < m_interval) {
+                return false;
+            }
+            m_count = 0;
+            T residual = detail::difference(x, m_input.data(), m_f.data(), m_size);
+            if (m_guarded) {
+                m_guarded = false;
+                if (!(residual <= m_guard)) {
+                    std::copy_n(m_backup.data(), m_size, x);
+                    std::swap(m_input, m_backup);
+                    restart();
+                    ++m_rejected;
+                    return true;
+                }
+            }
+
+            if (m_have_prev) {
+                push(x);
+            } else {
+                std::copy_n(x, m_size, m_g_prev.data());
+            }
+            m_have_prev = true;
+            ++m_since;
+
+            size_t need = m_kind == acceleration::aitken ? 2 : 1;
+            if (m_since < need || m_columns == 0) {
+                std::swap(m_f, m_f_prev);
+                std::copy_n(x, m_size, m_input.data());
+                return false;
+            }
+
+            m_guard = residual;
+            bool changed = m_kind == acceleration::aitken ? aitken(x) : anderson(x);
+            if (!changed) {
+                std::copy_n(x, m_size, m_input.data());
+            }
+            std::swap(m_f, m_f_prev);
+            m_since = 0;
+            if (changed) {
+                m_guarded = true;
+                ++m_extrapolations;
+            }
+            if (m_kind == acceleration::aitken) {
+                // The next extrapolation needs a fresh chain of plain steps.
+                restart();
+            }
+            return changed;
+        }
+
+        /**
+        * @brief Number of extrapolations made.
+        */
+        size_t extrapolations() const
+        {
+            return m_extrapolations;
+        }
+
+        /**
+        * @brief Number of extrapolations undone by the safeguard.
+        */
+        size_t rejected() const
+        {
+            return m_rejected;
+        }
+
+    protected:
+        void restart()
+        {
+            m_columns = 0;
+            m_next = 0;
+            m_since = 0;
+            m_count = 0;
+            m_have_prev = false;
+        }
+
+        /**
+        * @brief Records the differences of the residual and the step since the previous step.
+        */
+        void push(const T* x)
+        {
+            size_t s = m_next;
+            std::vector<T>& df = m_delta_f[s];
+            std::vector<T>& dg = m_delta_g[s];
+            for (size_t k = 0; k < m_size; ++k) {
+                df[k] = m_f[k] - m_f_prev[k];
+                dg[k] = x[k] - m_g_prev[k];
+                m_g_prev[k] = x[k];
+            }
+            m_columns = std::min(m_columns + 1, m_window);
+            m_next = (m_next + 1) % m_window;
+            for (size_t t = 0; t < m_columns; ++t) {
+                T dot = detail::dot(df.data(), m_delta_f[t].data(), m_size);
+                m_gram[s * m_window + t] = dot;
+                m_gram[t * m_window + s] = dot;
+            }
+        }
+
+        /**
+        * @brief x <- x - lambda * f with lambda = (f . df) / (df . df), df the last residual difference.
+        *
+        * With x2 = g(x1) = g(g(x0)) this is x2 - (d2 . (d2 - d1)) / |d2 - d1|^2 d2
+        * for the differences d1 = x1 - x0 and d2 = x2 - x1.
+        */
+        bool aitken(T* x)
+        {
+            size_t s = (m_next + m_window - 1) % m_window;
+            const std::vector<T>& df = m_delta_f[s];
+            T den = m_gram[s * m_window + s];
+            T num = detail::dot(m_f.data(), df.data(), m_size);
+            if (!(den > 0)) {
+                return false;
+            }
+            T lambda = num / den;
+            for (size_t k = 0; k < m_size; ++k) {
+                m_backup[k] = x[k];
+                x[k] -= lambda * m_f[k];
+                m_input[k] = x[k];
+            }
+            return true;
+        }
+
+        /**
+        * @brief x <- x - dG gamma, where gamma minimizes |f - dF gamma|.
+        *
+        * Solves the small normal equations dF^T dF gamma = dF^T f by
+        * Cholesky, with the Gram matrix kept up to date as columns are
+        * pushed and a relative ridge of 1e-10 of its trace so that nearly
+        * dependent columns do not blow up gamma.
+        */
+        bool anderson(T* x)
+        {
+            size_t m = m_columns;
+            gmat::dynmatrix<T> gram(m, m);
+            gmat::dynmatrix<T> gamma(m, 1);
+            T trace = 0;
+            for (size_t r = 0; r < m; ++r) {
+                trace += m_gram[r * m_window + r];
+            }
+            if (!(trace > 0)) {
+                return false;
+            }
+            for (size_t r = 0; r < m; ++r) {
+                for (size_t c = 0; c < m; ++c) {
+                    gram.set(r, c, m_gram[r * m_window + c]);
+                }
+                gram.set(r, r, gram.get(r, r) + T(1e-10) * trace);
+                gamma[r] = detail::dot(m_delta_f[r].data(), m_f.data(), m_size);
+            }
+            if (gmat::cholesky(gram)) {
+                return false;
+            }
+            gmat::cholesky_solve(gram, gamma);
+            std::copy_n(x, m_size, m_backup.data());
+            for (size_t r = 0; r < m; ++r) {
+                const std::vector<T>& dg = m_delta_g[r];
+                T g = gamma[r];
+                for (size_t k = 0; k < m_size; ++k) {
+                    x[k] -= g * dg[k];
+                }
+            }
+            std::copy_n(x, m_size, m_input.data());
+            return true;
+        }
+
+        acceleration m_kind;
+        size_t m_size, m_window, m_interval;
+
+        /**
+        * @brief The array last handed out, the step's residual, and those of the previous step.
+        */
+        std::vector<T> m_input, m_f, m_f_prev, m_g_prev;
+
+        /**
+        * @brief The plain iterate an extrapolation replaced, and the residual of its step.
+        */
+        std::vector<T> m_backup;
+        T m_guard;
+        bool m_guarded;
+
+        /**
+        * @brief Ring buffers of residual and step differences, and the Gram matrix of the former.
+        */
+        std::vector<std::vector<T>> m_delta_f, m_delta_g;
+        std::vector<T> m_gram;
+        size_t m_columns, m_next;
+
+        /**
+        * @brief Plain steps since the last call that did work, and steps of g^interval since the last extrapolation.
+        */
+        size_t m_count, m_since;
+        bool m_have_prev;
+        size_t m_extrapolations, m_rejected;
+    };
+}
+
+#endif // __ACCELERATOR_HH__
@@ -0,0 +1,328 @@
+#ifndef __BLOCK_SOLVER_HH__
+#define __BLOCK_SOLVER_HH__
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "gabp/dynmatrix.hh"
+#include "gabp/matrix.hh"
+#include "gabp/solver.hh"
+#include "gabp/sparse.hh"
+#include "gabp/symmatrix.hh"
+
+namespace gabp {
+    namespace detail {
+        /**
+        * @brief Overwrites x with P^-1 x for a d*d precision block P.
+        * @return true if P is singular; x is then unspecified.
+        *
+        * Cholesky is tried first, as precisions are positive definite on
+        * convergent problems; the general inverse covers the rest.
+        */
+        template <typename T, size_t d, size_t k>
+        bool solve_block(gmat::basematrix<T, d, d> p, gmat::basematrix<T, d, k>& x)
+        {
+            gmat::basematrix<T, d, d> l = p;
+            if (!gmat::cholesky(l)) {
+                gmat::cholesky_solve(l, x);
+                return false;
+            }
+            gmat::basematrix<T, d, d> inv;
+            if (gmat::inverse(p, inv)) {
+                return true;
+            }
+            gmat::basematrix<T, d, k> rhs = x;
+            gmat::matmul(inv, rhs, x);
+            return false;
+        }
+
+        template <typename T>
+        void add_to(T* dest, const T* src, size_t count)
+        {
+            for (size_t k = 0; k < count; ++k) {
+                dest[k] += src[k];
+            }
+        }
+
+        /**
+        * @brief Overwrites x with P^-1 x for a packed d*d precision block P.
+        * @return true if P is singular; x is then unspecified.
+        */
+        template <typename T, size_t d, size_t k>
+        bool solve_block(gmat::symmatrix<T, d> p, gmat::basematrix<T, d, k>& x)
+        {
+            gmat::symmatrix<T, d> u = p;
+            if (!gmat::cholesky(u)) {
+                gmat::cholesky_solve(u, x);
+                return false;
+            }
+            return solve_block(gmat::basematrix<T, d, d>(p), x);
+        }
+
+        /**
+        * @brief Computes the block message a variable s sends to a neighbor t.
+        * @param p_s,h_s Precision and h of s, summed over the prior and all incoming messages.
+        * @param p_in,h_in Message t sent to s, which is excluded.
+        * @param a Coupling block A_st, row-major, or A_ts if transposed is true.
+        * @param p_out,h_out Receive the message.
+        *
+        * With P = p_s - p_in and h = h_s - h_in, the message is
+        * P_st = -A_ts P^-1 A_st and h_st = -A_ts P^-1 h, where A_ts = A_st^T.
+        * Precisions are symmetric and kept packed. If P = U^T U, then with
+        * Y = U^-T [A_st | h] the message is minus the packed rank-d update
+        * Y_A^T Y_A and minus Y_A^T y_h, so one packed factorization and one
+        * triangular solve serve both. If P is not positive definite, the
+        * message is formed with the general inverse; a singular P yields a
+        * zero message.
+        */
+        template <typename T, size_t d>
+        void block_message(const gmat::symmatrix<T, d>& p_s, const gmat::basematrix<T, d, 1>& h_s,
+                           const gmat::symmatrix<T, d>& p_in, const gmat::basematrix<T, d, 1>& h_in,
+                           const T* a, bool transposed,
+                           gmat::symmatrix<T, d>& p_out, gmat::basematrix<T, d, 1>& h_out)
+        {
+            gmat::symmatrix<T, d> p_excl = p_s;
+            gmat::basematrix<T, d, d + 1> x;
+            const T* pm = p_in.data();
+            const T* hm = h_in.data();
+            T* pe = p_excl.data();
+            T* xd = x.data();
+            for (size_t k = 0; k < gmat::symmatrix<T, d>::packed_size; ++k) {
+                pe[k] -= pm[k];
+            }
+            // X = [A_st | h] with A_st(r, c) at a[r * d + c], or a[c * d + r] if transposed.
+            size_t rs = transposed ? 1 : d;
+            size_t cs = transposed ? d : 1;
+            for (size_t r = 0; r < d; ++r) {
+                for (size_t c = 0; c < d; ++c) {
+                    xd[r * (d + 1) + c] = a[r * rs + c * cs];
+                }
+                xd[r * (d + 1) + d] = h_s.data()[r] - hm[r];
+            }
+            gmat::matrix_view<const T, d, d> y_a(xd, d + 1);
+            gmat::matrix_view<const T, d, 1> y_h(xd + d, d + 1);
+            if (!gmat::cholesky(p_excl)) {
+                gmat::cholesky_forward(p_excl, x);
+                gmat::syrk(T(-1), y_a, T(0), p_out);
+                gmat::gemm(T(-1), gmat::transpose(y_a), y_h, T(0), h_out);
+                return;
+            }
+            gmat::basematrix<T, d, d> p = p_s;
+            p -= p_in;
+            if (solve_block(p, x)) {
+                p_out = gmat::symmatrix<T, d>(T(0));
+                h_out = gmat::basematrix<T, d, 1>(T(0));
+                return;
+            }
+            // -A_st^T P^-1 [A_st | h].
+            gmat::matrix_view<const T, d, d> a_st(a, rs, cs);
+            gmat::basematrix<T, d, d + 1> out;
+            gmat::gemm(T(-1), gmat::transpose(a_st), x, T(0), out);
+            p_out = gmat::matrix_view<const T, d, d>(out.data(), d + 1);
+            h_out = gmat::matrix_view<const T, d, 1>(out.data() + d, d + 1);
+        }
+    }
+
+    /**
+    * @brief Block Gaussian Belief Propagation solver for sparse symmetric systems A x = b.
+    * @tparam T Floating point type of elements.
+    * @tparam d Number of scalar unknowns per variable.
+    *
+    * A is given as a %sparse_matrix of d*d blocks, where block i,j couples
+    * variables i and j, and b and x as @a n*d vectors. Each edge carries a
+    * d*d symmetric precision message, packed as a %symmatrix, and a d*1 h
+    * message. All messages live in two contiguous pools indexed like the
+    * blocks of A, laid out as in %solver, so a message update is a
+    * fixed-size packed Cholesky factorization, triangular solve and rank-d
+    * update with no allocation.
+    *
+    * Only the synchronous schedule is implemented; options::policy and
+    * options::threads are ignored.
+    *
+    * @pre A is symmetric: block j,i is the transpose of block i,j and every
+    *      diagonal block is stored.
+    * @warning The %block_solver keeps a reference to A, which must outlive it.
+    */
+    template <typename T, size_t d>
+    class block_solver {
+    public:
+        typedef gmat::basematrix<T, d, d> block_type;
+        typedef gmat::symmatrix<T, d> message_type;
+        typedef gmat::basematrix<T, d, 1> vector_type;
+        typedef gmat::sparse_matrix<block_type> matrix_type;
+
+        /**
+        * @brief Creates a %block_solver for a fixed system matrix.
+        * @param mat Symmetric block sparse %matrix A in CSR layout.
+        * @param opts Tuning parameters.
+        */
+        explicit block_solver(const matrix_type& mat, options<T> opts = options<T>())
+            : m_mat(mat), m_opts(opts), m_iterations(0), m_updates(0), m_residual(0)
+        {
+            assert(mat.rows() == mat.cols());
+            detail::pair_edges(mat.rows(), mat.offsets(), mat.indices(), m_reverse, m_diag);
+            reset();
+        }
+
+        /**
+        * @brief Clears all messages, so the next solve starts from scratch.
+        */
+        void reset()
+        {
+            m_prec.assign(m_mat.nnz(), message_type(T(0)));
+            m_h.assign(m_mat.nnz(), vector_type(T(0)));
+            m_mean = gmat::dynmatrix<T>(m_mat.rows() * d, 1, T(0));
+            m_precision.assign(m_mat.rows(), block_type(T(0)));
+            m_iterations = 0;
+            m_updates = 0;
+        }
+
+        /**
+        * @brief Runs synchronous message passing for A x = b.
+        * @param b Right-hand side, an @a n*d by 1 %dynmatrix.
+        * @return true if the means did not converge within max_iterations.
+        *         false if they converged to tolerance.
+        */
+        bool solve(const gmat::dynmatrix<T>& b)
+        {
+            assert(b.size() == m_mat.rows() * d);
+            size_t n = m_mat.rows();
+            std::vector<message_type> prec_next(m_mat.nnz(), message_type(T(0)));
+            std::vector<vector_type> h_next(m_mat.nnz(), vector_type(T(0)));
+            m_iterations = 0;
+            m_updates = 0;
+            while (m_iterations < m_opts.max_iterations) {
+                ++m_iterations;
+                T change = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    vector_type mu = update(i, b.data() + i * d, prec_next.data(), h_next.data());
+                    for (size_t a = 0; a < d; ++a) {
+                        change = std::max(change, std::abs(mu.data()[a] - m_mean[i * d + a]));
+                        m_mean[i * d + a] = mu.data()[a];
+                    }
+                }
+                std::swap(m_prec, prec_next);
+                std::swap(m_h, h_next);
+                m_updates += m_mat.nnz() - n;
+                m_residual = change;
+                if (change < m_opts.tolerance) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+        * @brief Per-variable means stacked into the solution x once converged.
+        */
+        const gmat::dynmatrix<T>& mean() const
+        {
+            return m_mean;
+        }
+
+        /**
+        * @brief Marginal precision block of each variable.
+        */
+        const std::vector<block_type>& precision() const
+        {
+            return m_precision;
+        }
+
+        /**
+        * @brief Number of sweeps run by the last solve.
+        */
+        size_t iterations() const
+        {
+            return m_iterations;
+        }
+
+        /**
+        * @brief Number of message blocks computed by the last solve.
+        */
+        size_t updates() const
+        {
+            return m_updates;
+        }
+
+        /**
+        * @brief Largest change of any mean component during the last sweep.
+        */
+        T residual() const
+        {
+            return m_residual;
+        }
+
+        const options<T>& opts() const
+        {
+            return m_opts;
+        }
+
+    protected:
+        /**
+        * @brief Gathers the incoming messages of variable i and writes its outgoing messages.
+        * @param i Variable.
+        * @param bi The d entries of b belonging to variable i.
+        * @return The mean of variable i given its incoming messages.
+        *
+        * See detail::block_message for the message to each neighbor.
+        */
+        vector_type update(size_t i, const T* bi, message_type* prec_out, vector_type* h_out)
+        {
+            const size_t* off = m_mat.offsets();
+            const block_type* val = m_mat.values();
+            size_t dg = m_diag[i];
+            message_type p_i = dg < m_mat.nnz() ? message_type(val[dg]) : message_type(T(0));
+            vector_type h_i;
+            std::copy_n(bi, d, h_i.data());
+            for (size_t p = off[i]; p < off[i + 1]; ++p) {
+                detail::add_to(p_i.data(), m_prec[p].data(), message_type::packed_size);
+                detail::add_to(h_i.data(), m_h[p].data(), d);
+            }
+            m_precision[i] = p_i;
+
+            for (size_t p = off[i]; p < off[i + 1]; ++p) {
+                if (p == dg) {
+                    continue;
+                }
+                detail::block_message<T, d>(p_i, h_i, m_prec[p], m_h[p], val[p].data(), false,
+                                            prec_out[m_reverse[p]], h_out[m_reverse[p]]);
+            }
+
+            if (detail::solve_block(p_i, h_i)) {
+                return vector_type(T(0));
+            }
+            return h_i;
+        }
+
+        const matrix_type& m_mat;
+        options<T> m_opts;
+
+        /**
+        * @brief Position of block j,i for the block i,j stored at each position.
+        */
+        std::vector<size_t> m_reverse;
+
+        /**
+        * @brief Position of the diagonal block of each row, or nnz() if it is not stored.
+        */
+        std::vector<size_t> m_diag;
+
+        /**
+        * @brief Incoming precision and h message pools, indexed like the blocks of A.
+        */
+        std::vector<message_type> m_prec;
+        std::vector<vector_type> m_h;
+
+        gmat::dynmatrix<T> m_mean;
+        std::vector<block_type> m_precision;
+        size_t m_iterations;
+        size_t m_updates;
+        T m_residual;
+    };
+}
+
+#endif // __BLOCK_SOLVER_HH__
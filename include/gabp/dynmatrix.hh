@@ -0,0 +1,425 @@
+#ifndef __DYNMATRIX_HH__
+#define __DYNMATRIX_HH__
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "gabp/matrix.hh"
+
+namespace gmat {
+    /**
+    * @brief %matrix whose dimensions are chosen at runtime.
+    * @tparam T Type of elements. Must be trivially copyable.
+    *
+    * Elements are stored row-major. Matrices of up to @a inline_capacity
+    * elements live inside the object; larger ones are allocated on the heap,
+    * aligned to @a alignment bytes so that rows can be streamed with aligned
+    * vector loads. The inline buffer shares its space with the heap
+    * capacity, so a heap-backed %dynmatrix carries no more than that
+    * buffer, its data pointer and its dimensions. A %dynmatrix owns its
+    * storage and can only be moved; use clone() for an explicit deep copy.
+    */
+    template <typename T>
+    class dynmatrix {
+        static_assert(std::is_trivially_copyable<T>::value, "dynmatrix elements must be trivially copyable");
+
+    public:
+        typedef T value_type;
+
+        /**
+        * @brief Alignment in bytes of heap-allocated element storage.
+        */
+        static constexpr size_t alignment = 64;
+
+        /**
+        * @brief Largest number of elements stored inside the object without allocating.
+        */
+        static constexpr size_t inline_capacity = 128 / sizeof(T) > 0 ? 128 / sizeof(T) : 1;
+
+        /**
+        * @brief Creates an empty 0*0 %dynmatrix.
+        */
+        dynmatrix() : m_ptr(m_inline), m_rows(0), m_cols(0) { }
+
+        /**
+        * @brief Creates a %dynmatrix object.
+        * @param rows Number of rows.
+        * @param cols Number of columns.
+        * @warning Not necessarily zero-valued.
+        */
+        dynmatrix(size_t rows, size_t cols) : m_ptr(m_inline), m_rows(0), m_cols(0)
+        {
+            resize(rows, cols);
+        }
+
+        /**
+        * @brief Creates a %dynmatrix object with copies of an exemplar element.
+        * @param rows Number of rows.
+        * @param cols Number of columns.
+        * @param ex Exemplar element.
+        */
+        dynmatrix(size_t rows, size_t cols, T ex) : dynmatrix(rows, cols)
+        {
+            std::fill_n(m_ptr, size(), ex);
+        }
+
+        /**
+        * @brief Creates a %dynmatrix object holding a copy of a fixed-size %matrix.
+        * @param other %matrix or expression to evaluate.
+        */
+        template <typename D, size_t m, size_t n>
+        explicit dynmatrix(const static_matrix<D, T, m, n>& other) : dynmatrix(m, n)
+        {
+            for (size_t i = 0; i < m; ++i) {
+                for (size_t j = 0; j < n; ++j) {
+                    m_ptr[i * n + j] = other.derived().get(i, j);
+                }
+            }
+        }
+
+        dynmatrix(const dynmatrix&) = delete;
+        dynmatrix& operator=(const dynmatrix&) = delete;
+
+        dynmatrix(dynmatrix&& other) noexcept : m_ptr(m_inline), m_rows(0), m_cols(0)
+        {
+            take(other);
+        }
+
+        dynmatrix& operator=(dynmatrix&& other) noexcept
+        {
+            if (this != &other) {
+                release();
+                take(other);
+            }
+            return *this;
+        }
+
+        ~dynmatrix()
+        {
+            release();
+        }
+
+        /**
+        * @brief Makes a deep copy.
+        * @return New %dynmatrix with the same dimensions and elements.
+        */
+        dynmatrix clone() const
+        {
+            dynmatrix ret(m_rows, m_cols);
+            std::copy_n(m_ptr, size(), ret.m_ptr);
+            return ret;
+        }
+
+        /**
+        * @brief Changes the dimensions of the %dynmatrix.
+        * @param rows New number of rows.
+        * @param cols New number of columns.
+        *
+        * Storage is reused when it is large enough. Element values are
+        * unspecified afterwards.
+        */
+        void resize(size_t rows, size_t cols)
+        {
+            size_t count = rows * cols;
+            if (count > capacity()) {
+                release();
+                m_ptr = static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(alignment)));
+                m_capacity = count;
+            }
+            m_rows = rows;
+            m_cols = cols;
+        }
+
+        T get(size_t i, size_t j) const
+        {
+            return m_ptr[i * m_cols + j];
+        }
+
+        T set(size_t i, size_t j, T value)
+        {
+            return m_ptr[i * m_cols + j] = value;
+        }
+
+        /**
+        * @brief Accesses an element by its row-major linear index.
+        * @param k Index, i * cols() + j.
+        * @return Reference to the element.
+        *
+        * Convenient for vectors, whose second dimension is 1.
+        */
+        T& operator[](size_t k)
+        {
+            return m_ptr[k];
+        }
+
+        const T& operator[](size_t k) const
+        {
+            return m_ptr[k];
+        }
+
+        /**
+        * @brief Fixed-size window onto part of this %dynmatrix.
+        * @tparam m,n Dimensions of the window.
+        * @param i,j Coordinate of the top left element of the window.
+        * @return %matrix_view sharing storage with this %dynmatrix.
+        *
+        * @pre i + m <= rows()
+        * @pre j + n <= cols()
+        */
+        template <size_t m, size_t n>
+        matrix_view<T, m, n> block(size_t i, size_t j)
+        {
+            return matrix_view<T, m, n>(m_ptr + i * m_cols + j, m_cols);
+        }
+
+        template <size_t m, size_t n>
+        matrix_view<const T, m, n> block(size_t i, size_t j) const
+        {
+            return matrix_view<const T, m, n>(m_ptr + i * m_cols + j, m_cols);
+        }
+
+        size_t rows() const
+        {
+            return m_rows;
+        }
+
+        size_t cols() const
+        {
+            return m_cols;
+        }
+
+        size_t size() const
+        {
+            return m_rows * m_cols;
+        }
+
+        T* data()
+        {
+            return m_ptr;
+        }
+
+        const T* data() const
+        {
+            return m_ptr;
+        }
+
+        size_t row_stride() const
+        {
+            return m_cols;
+        }
+
+        size_t col_stride() const
+        {
+            return 1;
+        }
+
+    private:
+        bool on_heap() const
+        {
+            return m_ptr != m_inline;
+        }
+
+        size_t capacity() const
+        {
+            return on_heap() ? m_capacity : inline_capacity;
+        }
+
+        void release()
+        {
+            if (on_heap()) {
+                ::operator delete(m_ptr, std::align_val_t(alignment));
+                m_ptr = m_inline;
+            }
+        }
+
+        void take(dynmatrix& other)
+        {
+            if (other.on_heap()) {
+                m_ptr = other.m_ptr;
+                m_capacity = other.m_capacity;
+                other.m_ptr = other.m_inline;
+            } else {
+                std::copy_n(other.m_inline, other.size(), m_inline);
+            }
+            m_rows = other.m_rows;
+            m_cols = other.m_cols;
+            other.m_rows = other.m_cols = 0;
+        }
+
+        union {
+            T m_inline[inline_capacity];
+            // Number of elements allocated, while the elements are on the heap.
+            size_t m_capacity;
+        };
+        T* m_ptr;
+        size_t m_rows, m_cols;
+    };
+
+    /**
+     * @brief Calculates the product of two dynamically sized matrices and writes it into dest.
+     * @param left Left @a m*n %matrix to multiply.
+     * @param right Right @a n*o %matrix to multiply.
+     * @param dest @a m*o %matrix to write results.
+     *
+     * @pre left.cols() == right.rows()
+     * @pre dest does not share storage with left or right.
+     * @invariant left, right are unchanged.
+     *
+     * dest is resized if its dimensions differ.
+     */
+    template <typename T>
+    void matmul(const dynmatrix<T>& left, const dynmatrix<T>& right, dynmatrix<T>& dest)
+    {
+        assert(left.cols() == right.rows());
+        dest.resize(left.rows(), right.cols());
+        detail::gemm<T>(left.rows(), left.cols(), right.cols(), T(1), left.data(), left.row_stride(), 1,
+                        right.data(), right.row_stride(), 1, T(0), dest.data(), dest.row_stride());
+    }
+
+    /**
+     * @brief Calculates the entrywise sum of two dynamically sized matrices and writes it to dest.
+     * @param left Left %matrix to add.
+     * @param right Right %matrix of the same dimensions to add.
+     * @param dest %matrix to write results. May be left or right.
+     *
+     * dest is resized if its dimensions differ.
+     */
+    template <typename T>
+    void matadd(const dynmatrix<T>& left, const dynmatrix<T>& right, dynmatrix<T>& dest)
+    {
+        assert(left.rows() == right.rows() && left.cols() == right.cols());
+        dest.resize(left.rows(), left.cols());
+        const T* a = left.data();
+        const T* b = right.data();
+        T* c = dest.data();
+        for (size_t k = 0, count = left.size(); k < count; ++k) {
+            c[k] = a[k] + b[k];
+        }
+    }
+
+    /**
+    * @brief Calculates the determinant of a dynamically sized square %matrix.
+    * @param mat %matrix to calculate determinant of.
+    * @return Determinant of type T.
+    *
+    * @pre mat.rows() == mat.cols()
+    */
+    template <typename T>
+    T det(const dynmatrix<T>& mat)
+    {
+        assert(mat.rows() == mat.cols());
+        size_t n = mat.rows();
+        if (n == 0) {
+            return T(1);
+        }
+        dynmatrix<T> tmp = mat.clone();
+        if constexpr (std::is_integral<T>::value) {
+            return detail::bareiss_det(n, tmp.data(), n);
+        } else {
+            std::vector<size_t> piv(n);
+            if (detail::lu_factor(n, tmp.data(), n, piv.data())) {
+                return T(0);
+            }
+            T acc = 1;
+            for (size_t k = 0; k < n; ++k) {
+                acc *= piv[k] == k ? tmp[k * n + k] : -tmp[k * n + k];
+            }
+            return acc;
+        }
+    }
+
+    namespace detail {
+        template <size_t n, typename T>
+        bool fixed_inverse(const dynmatrix<T>& src, dynmatrix<T>& dest)
+        {
+            basematrix<T, n, n> inv;
+            if (inverse(src.template block<n, n>(0, 0), inv)) {
+                return true;
+            }
+            dest.resize(n, n);
+            matrix_view<T, n, n> out = dest.template block<n, n>(0, 0);
+            out = inv;
+            return false;
+        }
+    }
+    /**
+    * @brief Calculates the %inverse of a dynamically sized square %matrix and writes it into dest.
+    * @tparam T Floating point type of elements.
+    * @param src %matrix to invert.
+    * @param dest %matrix to write results.
+    * @return true if src is singular (ie non-invertible).
+    *         false if src is non-singular (ie invertible).
+    *
+    * @pre src.rows() == src.cols()
+    * @invariant src is unchanged.
+    *
+    * Orders 1 to 4 reuse the closed-form fixed-size inverse. On success dest
+    * is resized to match src; if src is singular dest is left unchanged.
+    */
+    template <typename T>
+    bool inverse(const dynmatrix<T>& src, dynmatrix<T>& dest)
+    {
+        static_assert(std::is_floating_point<T>::value, "inverse requires a floating point element type");
+        assert(src.rows() == src.cols());
+        size_t n = src.rows();
+        switch (n) {
+        case 1:
+            return detail::fixed_inverse<1>(src, dest);
+        case 2:
+            return detail::fixed_inverse<2>(src, dest);
+        case 3:
+            return detail::fixed_inverse<3>(src, dest);
+        case 4:
+            return detail::fixed_inverse<4>(src, dest);
+        default:
+            break;
+        }
+        dynmatrix<T> lu = src.clone();
+        std::vector<size_t> piv(n);
+        if (detail::lu_factor(n, lu.data(), n, piv.data())) {
+            return true;
+        }
+        dynmatrix<T> inv(n, n, T(0));
+        for (size_t i = 0; i < n; ++i) {
+            inv[i * n + i] = T(1);
+        }
+        detail::lu_solve(n, lu.data(), n, piv.data(), inv.data(), n, n);
+        dest = std::move(inv);
+        return false;
+    }
+
+    /**
+    * @brief Factors a dynamically sized symmetric positive definite %matrix in place, A = L L^T.
+    * @param mat %matrix to factor; its lower triangle is overwritten with L.
+    * @return true if mat is not positive definite.
+    *
+    * @pre mat.rows() == mat.cols()
+    */
+    template <typename T>
+    bool cholesky(dynmatrix<T>& mat)
+    {
+        assert(mat.rows() == mat.cols());
+        return detail::cholesky_factor(mat.rows(), mat.data(), mat.row_stride(), 1);
+    }
+
+    /**
+    * @brief Solves A X = B in place, given the Cholesky factor of A.
+    * @param chol Factor L written by cholesky.
+    * @param rhs Right-hand sides, one per column, overwritten with the solution.
+    *
+    * @pre rhs.rows() == chol.rows()
+    */
+    template <typename T>
+    void cholesky_solve(const dynmatrix<T>& chol, dynmatrix<T>& rhs)
+    {
+        assert(rhs.rows() == chol.rows());
+        detail::cholesky_solve(chol.rows(), chol.data(), chol.row_stride(), 1,
+                               rhs.data(), rhs.row_stride(), 1, rhs.cols());
+    }
+}
+
+#endif // __DYNMATRIX_HH__
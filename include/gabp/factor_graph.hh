@@ -0,0 +1,445 @@
+#ifndef __FACTOR_GRAPH_HH__
+#define __FACTOR_GRAPH_HH__
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+#include "gabp/block_solver.hh"
+#include "gabp/dynmatrix.hh"
+#include "gabp/matrix.hh"
+#include "gabp/solver.hh"
+#include "gabp/sparse.hh"
+#include "gabp/symmatrix.hh"
+
+namespace gabp {
+    /**
+    * @brief Gaussian factor graph that changes online, kept converged by local message passing.
+    * @tparam T Floating point type of elements.
+    * @tparam d Number of scalar unknowns per variable.
+    *
+    * Variables carry a d*d prior precision and a d*1 prior h. Each factor
+    * couples two variables and contributes the blocks Λ_ii, Λ_ij and Λ_jj of
+    * the information form, so that the graph encodes A x = b with A_ii the
+    * prior plus the Λ_ii of all factors at i, A_ij = Λ_ij and b_i the prior
+    * h. Adding or removing a variable or a factor is amortized O(1), plus
+    * the degree of a removed variable; slots of removed ones are recycled.
+    * Priors, the Λ_ii and all precision messages are symmetric and kept as
+    * packed %symmatrix blocks; only the upper triangle of the blocks passed
+    * in is read.
+    *
+    * Changes only mark the variables they touch. propagate() then runs
+    * block GaBP from those variables outwards, in place and in FIFO order,
+    * and a neighbor is updated only when a message it receives changes by
+    * at least the tolerance, so the cost follows the size of the region the
+    * change actually affects rather than the size of the graph.
+    *
+    * @pre At most one factor joins any pair of variables; merge repeated
+    *      measurements into one factor.
+    */
+    template <typename T, size_t d>
+    class factor_graph {
+    public:
+        typedef gmat::basematrix<T, d, d> block_type;
+        typedef gmat::symmatrix<T, d> message_type;
+        typedef gmat::basematrix<T, d, 1> vector_type;
+
+        /**
+        * @brief Creates an empty %factor_graph.
+        * @param opts Tuning parameters. Each propagate() performs at most
+        *             max_iterations times the number of variables updates.
+        */
+        explicit factor_graph(options<T> opts = options<T>()) : m_opts(opts), m_live_variables(0), m_live_factors(0), m_updates(0) { }
+
+        /**
+        * @brief Adds a variable.
+        * @param prec Prior precision block.
+        * @param h Prior precision-weighted mean.
+        * @return Id of the variable, valid until it is removed.
+        */
+        size_t add_variable(const block_type& prec, const vector_type& h)
+        {
+            size_t v;
+            if (m_free_variables.empty()) {
+                v = m_variables.size();
+                m_variables.emplace_back();
+                m_queued.push_back(0);
+                m_mean.emplace_back(T(0));
+                m_precision.emplace_back(T(0));
+            } else {
+                v = m_free_variables.back();
+                m_free_variables.pop_back();
+            }
+            variable& var = m_variables[v];
+            var.prec = prec;
+            var.h = h;
+            var.edges.clear();
+            var.alive = true;
+            m_mean[v] = vector_type(T(0));
+            m_precision[v] = prec;
+            ++m_live_variables;
+            touch(v);
+            return v;
+        }
+
+        /**
+        * @brief Removes a variable and every factor attached to it.
+        * @param v Id of a live variable.
+        */
+        void remove_variable(size_t v)
+        {
+            assert(alive(v));
+            while (!m_variables[v].edges.empty()) {
+                remove_factor(m_variables[v].edges.back());
+            }
+            m_variables[v].alive = false;
+            m_free_variables.push_back(v);
+            --m_live_variables;
+        }
+
+        /**
+        * @brief Changes the prior h of a variable, as when a measurement of it is updated.
+        */
+        void set_prior(size_t v, const vector_type& h)
+        {
+            assert(alive(v));
+            m_variables[v].h = h;
+            touch(v);
+        }
+
+        /**
+        * @brief Adds a factor between two variables.
+        * @param i,j Ids of two distinct live variables.
+        * @param ii Contribution Λ_ii to the diagonal block of i.
+        * @param ij Coupling block Λ_ij; Λ_ji is its transpose.
+        * @param jj Contribution Λ_jj to the diagonal block of j.
+        * @return Id of the factor, valid until it is removed.
+        */
+        size_t add_factor(size_t i, size_t j, const block_type& ii, const block_type& ij, const block_type& jj)
+        {
+            assert(alive(i) && alive(j) && i != j);
+            size_t f;
+            if (m_free_factors.empty()) {
+                f = m_factors.size();
+                m_factors.emplace_back();
+                m_msg_prec.resize(2 * m_factors.size());
+                m_msg_h.resize(2 * m_factors.size());
+            } else {
+                f = m_free_factors.back();
+                m_free_factors.pop_back();
+            }
+            factor& fac = m_factors[f];
+            fac.ends[0] = i;
+            fac.ends[1] = j;
+            fac.diag[0] = ii;
+            fac.diag[1] = jj;
+            fac.coupling = ij;
+            fac.alive = true;
+            for (size_t s = 0; s < 2; ++s) {
+                std::vector<size_t>& edges = m_variables[fac.ends[s]].edges;
+                fac.slot[s] = edges.size();
+                edges.push_back(f);
+                m_msg_prec[2 * f + s] = message_type(T(0));
+                m_msg_h[2 * f + s] = vector_type(T(0));
+            }
+            ++m_live_factors;
+            touch(i);
+            touch(j);
+            return f;
+        }
+
+        /**
+        * @brief Removes a factor.
+        * @param f Id of a live factor.
+        */
+        void remove_factor(size_t f)
+        {
+            assert(f < m_factors.size() && m_factors[f].alive);
+            factor& fac = m_factors[f];
+            for (size_t s = 0; s < 2; ++s) {
+                // Swap-remove from the end's edge list, fixing the moved factor's slot.
+                std::vector<size_t>& edges = m_variables[fac.ends[s]].edges;
+                size_t moved = edges.back();
+                edges[fac.slot[s]] = moved;
+                factor& other = m_factors[moved];
+                other.slot[other.ends[0] == fac.ends[s] ? 0 : 1] = fac.slot[s];
+                edges.pop_back();
+                touch(fac.ends[s]);
+            }
+            fac.alive = false;
+            m_free_factors.push_back(f);
+            --m_live_factors;
+        }
+
+        /**
+        * @brief Passes messages from the variables touched since the last call until they settle.
+        * @return true if the update budget ran out before every message settled.
+        */
+        bool propagate()
+        {
+            size_t budget = m_opts.max_iterations * m_live_variables;
+            size_t runs = 0;
+            m_updates = 0;
+            std::vector<size_t> refresh;
+            while (!m_queue.empty()) {
+                size_t v = m_queue.front();
+                // Removed variables are dropped before the budget check, so
+                // they cannot leave the queue non-empty on their own.
+                if (m_variables[v].alive && runs == budget) {
+                    break;
+                }
+                m_queue.pop_front();
+                m_queued[v] = 0;
+                if (!m_variables[v].alive) {
+                    continue;
+                }
+                ++runs;
+                update(v, refresh);
+            }
+            bool failed = !m_queue.empty();
+            for (size_t v : refresh) {
+                if (m_variables[v].alive) {
+                    refresh_mean(v);
+                }
+            }
+            return failed;
+        }
+
+        bool alive(size_t v) const
+        {
+            return v < m_variables.size() && m_variables[v].alive;
+        }
+
+        /**
+        * @brief Mean of a variable as of the last propagate().
+        */
+        const vector_type& mean(size_t v) const
+        {
+            return m_mean[v];
+        }
+
+        /**
+        * @brief Marginal precision of a variable as of the last propagate().
+        */
+        const block_type& precision(size_t v) const
+        {
+            return m_precision[v];
+        }
+
+        /**
+        * @brief Number of live variables.
+        */
+        size_t variables() const
+        {
+            return m_live_variables;
+        }
+
+        /**
+        * @brief Number of live factors.
+        */
+        size_t factors() const
+        {
+            return m_live_factors;
+        }
+
+        /**
+        * @brief Number of variable slots, live or recycled; ids are below this.
+        */
+        size_t capacity() const
+        {
+            return m_variables.size();
+        }
+
+        /**
+        * @brief Number of message blocks computed by the last propagate().
+        */
+        size_t updates() const
+        {
+            return m_updates;
+        }
+
+        /**
+        * @brief Builds the block system the graph encodes, one row per variable slot.
+        * @return Block %sparse_matrix A. Recycled slots get an identity
+        *         diagonal block and no coupling, so their solution is zero.
+        */
+        gmat::sparse_matrix<block_type> matrix() const
+        {
+            gmat::coo_builder<block_type> coo(capacity(), capacity());
+            coo.reserve(capacity() + 4 * m_live_factors);
+            for (size_t v = 0; v < capacity(); ++v) {
+                if (!m_variables[v].alive) {
+                    block_type eye(T(0));
+                    for (size_t r = 0; r < d; ++r) {
+                        eye.set(r, r, T(1));
+                    }
+                    coo.add(v, v, eye);
+                } else {
+                    coo.add(v, v, block_type(m_variables[v].prec));
+                }
+            }
+            for (const factor& fac : m_factors) {
+                if (!fac.alive) {
+                    continue;
+                }
+                coo.add(fac.ends[0], fac.ends[0], block_type(fac.diag[0]));
+                coo.add(fac.ends[1], fac.ends[1], block_type(fac.diag[1]));
+                coo.add(fac.ends[0], fac.ends[1], fac.coupling);
+                coo.add(fac.ends[1], fac.ends[0], block_type(gmat::transpose(fac.coupling)));
+            }
+            return coo.build();
+        }
+
+        /**
+        * @brief Builds the right-hand side the graph encodes, matching matrix().
+        */
+        gmat::dynmatrix<T> rhs() const
+        {
+            gmat::dynmatrix<T> b(capacity() * d, 1, T(0));
+            for (size_t v = 0; v < capacity(); ++v) {
+                if (m_variables[v].alive) {
+                    std::copy_n(m_variables[v].h.data(), d, b.data() + v * d);
+                }
+            }
+            return b;
+        }
+
+        const options<T>& opts() const
+        {
+            return m_opts;
+        }
+
+    protected:
+        struct variable {
+            message_type prec;
+            vector_type h;
+
+            /**
+            * @brief Ids of the attached factors.
+            */
+            std::vector<size_t> edges;
+            bool alive = false;
+        };
+
+        /**
+        * @brief A factor joining ends[0] and ends[1].
+        *
+        * The message from ends[s] to the other end is stored at 2 * id + s.
+        */
+        struct factor {
+            size_t ends[2];
+
+            /**
+            * @brief Position of this factor in the edge list of each end.
+            */
+            size_t slot[2];
+            message_type diag[2];
+            block_type coupling;
+            bool alive = false;
+        };
+
+        void touch(size_t v)
+        {
+            if (!m_queued[v]) {
+                m_queued[v] = 1;
+                m_queue.push_back(v);
+            }
+        }
+
+        /**
+        * @brief Sums the prior, the factor diagonals and the incoming messages of v.
+        */
+        void belief(size_t v, message_type& p, vector_type& h) const
+        {
+            const variable& var = m_variables[v];
+            p = var.prec;
+            h = var.h;
+            for (size_t f : var.edges) {
+                const factor& fac = m_factors[f];
+                size_t s = fac.ends[0] == v ? 0 : 1;
+                detail::add_to(p.data(), fac.diag[s].data(), message_type::packed_size);
+                detail::add_to(p.data(), m_msg_prec[2 * f + 1 - s].data(), message_type::packed_size);
+                detail::add_to(h.data(), m_msg_h[2 * f + 1 - s].data(), d);
+            }
+        }
+
+        void refresh_mean(size_t v)
+        {
+            message_type p;
+            vector_type h;
+            belief(v, p, h);
+            m_precision[v] = p;
+            if (detail::solve_block(p, h)) {
+                h = vector_type(T(0));
+            }
+            m_mean[v] = h;
+        }
+
+        /**
+        * @brief Sends the messages of v and queues the neighbors they changed.
+        * @param refresh Receives variables whose mean must be recomputed.
+        */
+        void update(size_t v, std::vector<size_t>& refresh)
+        {
+            message_type p;
+            vector_type h;
+            belief(v, p, h);
+            refresh.push_back(v);
+            for (size_t f : m_variables[v].edges) {
+                const factor& fac = m_factors[f];
+                size_t s = fac.ends[0] == v ? 0 : 1;
+                size_t u = fac.ends[1 - s];
+                message_type p_out;
+                vector_type h_out;
+                // The coupling is stored as Λ_{ends[0], ends[1]}.
+                detail::block_message<T, d>(p, h, m_msg_prec[2 * f + 1 - s], m_msg_h[2 * f + 1 - s],
+                                            fac.coupling.data(), s == 1, p_out, h_out);
+                T delta = 0;
+                const T* po = m_msg_prec[2 * f + s].data();
+                const T* ho = m_msg_h[2 * f + s].data();
+                for (size_t k = 0; k < message_type::packed_size; ++k) {
+                    delta = std::max(delta, std::abs(p_out.data()[k] - po[k]));
+                }
+                for (size_t k = 0; k < d; ++k) {
+                    delta = std::max(delta, std::abs(h_out.data()[k] - ho[k]));
+                }
+                m_msg_prec[2 * f + s] = p_out;
+                m_msg_h[2 * f + s] = h_out;
+                ++m_updates;
+                if (delta >= m_opts.tolerance) {
+                    touch(u);
+                } else {
+                    refresh.push_back(u);
+                }
+            }
+        }
+
+        options<T> m_opts;
+        std::vector<variable> m_variables;
+        std::vector<factor> m_factors;
+        std::vector<size_t> m_free_variables, m_free_factors;
+
+        /**
+        * @brief Message pools, two entries per factor slot.
+        */
+        std::vector<message_type> m_msg_prec;
+        std::vector<vector_type> m_msg_h;
+
+        std::vector<vector_type> m_mean;
+        std::vector<block_type> m_precision;
+
+        /**
+        * @brief Variables waiting for an update, in FIFO order, and a flag per slot.
+        */
+        std::deque<size_t> m_queue;
+        std::vector<char> m_queued;
+
+        size_t m_live_variables, m_live_factors;
+        size_t m_updates;
+    };
+}
+
+#endif // __FACTOR_GRAPH_HH__
@@ -0,0 +1,945 @@
+#ifndef __KERNELS_HH__
+#define __KERNELS_HH__
+
+#include <cstddef>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+#if defined(__AVX512F__) || defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace gmat {
+    /**
+     * @brief Implementation details of the %gmat backend. Not part of the public interface.
+     */
+    namespace detail {
+        /**
+        * @brief Thin wrapper over the widest vector registers enabled at compile time.
+        * @tparam T Type of elements.
+        *
+        * The generic version is a single scalar lane, used for element types
+        * other than float and double and on targets without SSE2.
+        */
+        template <typename T>
+        struct simd {
+            typedef T type;
+            static constexpr size_t width = 1;
+
+            static type zero() { return T(0); }
+            static type broadcast(T x) { return x; }
+            static type load(const T* p) { return *p; }
+            static void store(T* p, type v) { *p = v; }
+            static type fmadd(type a, type b, type c) { return a * b + c; }
+            static type mul(type a, type b) { return a * b; }
+            static type add(type a, type b) { return a + b; }
+        };
+
+#if defined(__AVX512F__)
+        template <>
+        struct simd<double> {
+            typedef __m512d type;
+            static constexpr size_t width = 8;
+
+            static type zero() { return _mm512_setzero_pd(); }
+            static type broadcast(double x) { return _mm512_set1_pd(x); }
+            static type load(const double* p) { return _mm512_loadu_pd(p); }
+            static void store(double* p, type v) { _mm512_storeu_pd(p, v); }
+            static type fmadd(type a, type b, type c) { return _mm512_fmadd_pd(a, b, c); }
+            static type mul(type a, type b) { return _mm512_mul_pd(a, b); }
+            static type add(type a, type b) { return _mm512_add_pd(a, b); }
+        };
+
+        template <>
+        struct simd<float> {
+            typedef __m512 type;
+            static constexpr size_t width = 16;
+
+            static type zero() { return _mm512_setzero_ps(); }
+            static type broadcast(float x) { return _mm512_set1_ps(x); }
+            static type load(const float* p) { return _mm512_loadu_ps(p); }
+            static void store(float* p, type v) { _mm512_storeu_ps(p, v); }
+            static type fmadd(type a, type b, type c) { return _mm512_fmadd_ps(a, b, c); }
+            static type mul(type a, type b) { return _mm512_mul_ps(a, b); }
+            static type add(type a, type b) { return _mm512_add_ps(a, b); }
+        };
+#elif defined(__AVX__)
+        template <>
+        struct simd<double> {
+            typedef __m256d type;
+            static constexpr size_t width = 4;
+
+            static type zero() { return _mm256_setzero_pd(); }
+            static type broadcast(double x) { return _mm256_set1_pd(x); }
+            static type load(const double* p) { return _mm256_loadu_pd(p); }
+            static void store(double* p, type v) { _mm256_storeu_pd(p, v); }
+#if defined(__FMA__)
+            static type fmadd(type a, type b, type c) { return _mm256_fmadd_pd(a, b, c); }
+#else
+            static type fmadd(type a, type b, type c) { return _mm256_add_pd(_mm256_mul_pd(a, b), c); }
+#endif
+            static type mul(type a, type b) { return _mm256_mul_pd(a, b); }
+            static type add(type a, type b) { return _mm256_add_pd(a, b); }
+        };
+
+        template <>
+        struct simd<float> {
+            typedef __m256 type;
+            static constexpr size_t width = 8;
+
+            static type zero() { return _mm256_setzero_ps(); }
+            static type broadcast(float x) { return _mm256_set1_ps(x); }
+            static type load(const float* p) { return _mm256_loadu_ps(p); }
+            static void store(float* p, type v) { _mm256_storeu_ps(p, v); }
+#if defined(__FMA__)
+            static type fmadd(type a, type b, type c) { return _mm256_fmadd_ps(a, b, c); }
+#else
+            static type fmadd(type a, type b, type c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+#endif
+            static type mul(type a, type b) { return _mm256_mul_ps(a, b); }
+            static type add(type a, type b) { return _mm256_add_ps(a, b); }
+        };
+#elif defined(__SSE2__)
+        template <>
+        struct simd<double> {
+            typedef __m128d type;
+            static constexpr size_t width = 2;
+
+            static type zero() { return _mm_setzero_pd(); }
+            static type broadcast(double x) { return _mm_set1_pd(x); }
+            static type load(const double* p) { return _mm_loadu_pd(p); }
+            static void store(double* p, type v) { _mm_storeu_pd(p, v); }
+            static type fmadd(type a, type b, type c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+            static type mul(type a, type b) { return _mm_mul_pd(a, b); }
+            static type add(type a, type b) { return _mm_add_pd(a, b); }
+        };
+
+        template <>
+        struct simd<float> {
+            typedef __m128 type;
+            static constexpr size_t width = 4;
+
+            static type zero() { return _mm_setzero_ps(); }
+            static type broadcast(float x) { return _mm_set1_ps(x); }
+            static type load(const float* p) { return _mm_loadu_ps(p); }
+            static void store(float* p, type v) { _mm_storeu_ps(p, v); }
+            static type fmadd(type a, type b, type c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+            static type mul(type a, type b) { return _mm_mul_ps(a, b); }
+            static type add(type a, type b) { return _mm_add_ps(a, b); }
+        };
+#endif
+
+        /**
+        * @brief Blocking parameters of the %gemm kernel.
+        * @tparam T Type of elements.
+        *
+        * The micro-kernel keeps an @a mr * @a nr tile of the result in
+        * registers. Operands are packed in @a kc * @a mc panels of the left
+        * %matrix and @a kc * @a nc panels of the right one once the problem
+        * no longer fits in @a l1 bytes.
+        */
+        template <typename T>
+        struct gemm_blocking {
+            static constexpr size_t mr = 4;
+            static constexpr size_t nr = 2 * simd<T>::width;
+            static constexpr size_t kc = 256;
+            static constexpr size_t mc = 96;
+            static constexpr size_t nc = 1024;
+            static constexpr size_t l1 = 32 * 1024;
+        };
+
+        /**
+        * @brief Computes an @a mr * @a nr tile C = alpha * A * B + beta * C.
+        *
+        * Element (i, k) of A is read at a[i * rsa + k * csa], which covers
+        * both packed panels and row-major operands. Each row of B must hold
+        * @a nr contiguous elements starting at b + k * rsb.
+        */
+        template <typename T>
+        inline void micro_kernel(size_t kc, T alpha, const T* a, size_t rsa, size_t csa,
+                                 const T* b, size_t rsb, T beta, T* c, size_t ldc)
+        {
+            typedef simd<T> V;
+            typedef typename V::type vec;
+            constexpr size_t w = V::width;
+
+            vec c00 = V::zero(), c01 = V::zero();
+            vec c10 = V::zero(), c11 = V::zero();
+            vec c20 = V::zero(), c21 = V::zero();
+            vec c30 = V::zero(), c31 = V::zero();
+            for (size_t k = 0; k < kc; ++k) {
+                const T* bk = b + k * rsb;
+                const T* ak = a + k * csa;
+                vec b0 = V::load(bk);
+                vec b1 = V::load(bk + w);
+                vec a0 = V::broadcast(ak[0]);
+                c00 = V::fmadd(a0, b0, c00);
+                c01 = V::fmadd(a0, b1, c01);
+                vec a1 = V::broadcast(ak[rsa]);
+                c10 = V::fmadd(a1, b0, c10);
+                c11 = V::fmadd(a1, b1, c11);
+                vec a2 = V::broadcast(ak[2 * rsa]);
+                c20 = V::fmadd(a2, b0, c20);
+                c21 = V::fmadd(a2, b1, c21);
+                vec a3 = V::broadcast(ak[3 * rsa]);
+                c30 = V::fmadd(a3, b0, c30);
+                c31 = V::fmadd(a3, b1, c31);
+            }
+
+            vec acc[4][2] = { { c00, c01 }, { c10, c11 }, { c20, c21 }, { c30, c31 } };
+            vec va = V::broadcast(alpha);
+            vec vb = V::broadcast(beta);
+            for (size_t i = 0; i < 4; ++i) {
+                for (size_t h = 0; h < 2; ++h) {
+                    T* ci = c + i * ldc + h * w;
+                    if (beta == T(0)) {
+                        V::store(ci, V::mul(va, acc[i][h]));
+                    } else {
+                        V::store(ci, V::fmadd(va, acc[i][h], V::mul(vb, V::load(ci))));
+                    }
+                }
+            }
+        }
+
+        /**
+        * @brief Scalar C = alpha * A * B + beta * C over an arbitrary block, used for edges.
+        */
+        template <typename T>
+        inline void gemm_scalar(size_t m, size_t n, size_t o, T alpha, const T* a, size_t rsa, size_t csa,
+                                const T* b, size_t rsb, size_t csb, T beta, T* c, size_t ldc)
+        {
+            for (size_t i = 0; i < m; ++i) {
+                for (size_t j = 0; j < o; ++j) {
+                    T acc = 0;
+                    for (size_t k = 0; k < n; ++k) {
+                        acc += a[i * rsa + k * csa] * b[k * rsb + j * csb];
+                    }
+                    T& cij = c[i * ldc + j];
+                    cij = beta == T(0) ? alpha * acc : alpha * acc + beta * cij;
+                }
+            }
+        }
+
+        /**
+        * @brief Packs a @a mc * @a kc block of A into @a mr -row panels, zero-padding the last one.
+        */
+        template <typename T>
+        inline void pack_a(size_t mc, size_t kc, const T* a, size_t rsa, size_t csa, T* dst)
+        {
+            constexpr size_t mr = gemm_blocking<T>::mr;
+            for (size_t i = 0; i < mc; i += mr) {
+                size_t rows = std::min(mr, mc - i);
+                for (size_t k = 0; k < kc; ++k) {
+                    for (size_t r = 0; r < mr; ++r) {
+                        *dst++ = r < rows ? a[(i + r) * rsa + k * csa] : T(0);
+                    }
+                }
+            }
+        }
+
+        /**
+        * @brief Packs a @a kc * @a nc block of B into @a nr -column panels, zero-padding the last one.
+        */
+        template <typename T>
+        inline void pack_b(size_t kc, size_t nc, const T* b, size_t rsb, size_t csb, T* dst)
+        {
+            constexpr size_t nr = gemm_blocking<T>::nr;
+            for (size_t j = 0; j < nc; j += nr) {
+                size_t cols = std::min(nr, nc - j);
+                for (size_t k = 0; k < kc; ++k) {
+                    const T* bk = b + k * rsb + j * csb;
+                    for (size_t q = 0; q < nr; ++q) {
+                        *dst++ = q < cols ? bk[q * csb] : T(0);
+                    }
+                }
+            }
+        }
+
+        /**
+        * @brief General %matrix product C = alpha * A * B + beta * C.
+        * @tparam T Type of elements.
+        * @param m,n,o A is @a m*n, B is @a n*o and C is @a m*o.
+        * @param a,rsa,csa Left operand and its row and column strides.
+        * @param b,rsb,csb Right operand and its row and column strides.
+        * @param c,ldc Result and its row stride. Columns of C are contiguous.
+        *
+        * Small problems whose operands fit in L1 and whose right operand has
+        * contiguous rows run the register-blocked micro-kernel directly on the
+        * operands. Larger ones are tiled and packed so that each micro-kernel
+        * call streams through panels resident in cache. If beta is zero, C is
+        * not read.
+        *
+        * @pre C does not overlap A or B.
+        */
+        template <typename T>
+        void gemm(size_t m, size_t n, size_t o, T alpha, const T* a, size_t rsa, size_t csa,
+                  const T* b, size_t rsb, size_t csb, T beta, T* c, size_t ldc)
+        {
+            typedef gemm_blocking<T> blk;
+            constexpr size_t mr = blk::mr;
+            constexpr size_t nr = blk::nr;
+
+            if (n == 0) {
+                gemm_scalar<T>(m, 0, o, alpha, a, rsa, csa, b, rsb, csb, beta, c, ldc);
+                return;
+            }
+
+            if (csb == 1 && (m * n + n * o + m * o) * sizeof(T) <= blk::l1) {
+                size_t mm = m - m % mr;
+                size_t oo = o - o % nr;
+                for (size_t i = 0; i < mm; i += mr) {
+                    for (size_t j = 0; j < oo; j += nr) {
+                        micro_kernel<T>(n, alpha, a + i * rsa, rsa, csa, b + j, rsb, beta, c + i * ldc + j, ldc);
+                    }
+                }
+                gemm_scalar<T>(mm, n, o - oo, alpha, a, rsa, csa, b + oo, rsb, csb, beta, c + oo, ldc);
+                gemm_scalar<T>(m - mm, n, o, alpha, a + mm * rsa, rsa, csa, b, rsb, csb, beta, c + mm * ldc, ldc);
+                return;
+            }
+
+            thread_local std::vector<T> apack, bpack;
+            apack.resize(blk::mc * blk::kc);
+            bpack.resize(blk::kc * (blk::nc + nr));
+
+            T tile[mr * nr];
+            for (size_t jc = 0; jc < o; jc += blk::nc) {
+                size_t nc = std::min(blk::nc, o - jc);
+                for (size_t pc = 0; pc < n; pc += blk::kc) {
+                    size_t kc = std::min(blk::kc, n - pc);
+                    T b_pc = pc == 0 ? beta : T(1);
+                    pack_b<T>(kc, nc, b + pc * rsb + jc * csb, rsb, csb, bpack.data());
+                    for (size_t ic = 0; ic < m; ic += blk::mc) {
+                        size_t mc = std::min(blk::mc, m - ic);
+                        pack_a<T>(mc, kc, a + ic * rsa + pc * csa, rsa, csa, apack.data());
+                        for (size_t jr = 0; jr < nc; jr += nr) {
+                            size_t cols = std::min(nr, nc - jr);
+                            const T* bp = bpack.data() + jr * kc;
+                            for (size_t ir = 0; ir < mc; ir += mr) {
+                                size_t rows = std::min(mr, mc - ir);
+                                const T* ap = apack.data() + ir * kc;
+                                T* cp = c + (ic + ir) * ldc + jc + jr;
+                                if (rows == mr && cols == nr) {
+                                    micro_kernel<T>(kc, alpha, ap, 1, mr, bp, nr, b_pc, cp, ldc);
+                                } else {
+                                    micro_kernel<T>(kc, alpha, ap, 1, mr, bp, nr, T(0), tile, nr);
+                                    for (size_t i = 0; i < rows; ++i) {
+                                        for (size_t j = 0; j < cols; ++j) {
+                                            T& cij = cp[i * ldc + j];
+                                            cij = b_pc == T(0) ? tile[i * nr + j] : tile[i * nr + j] + b_pc * cij;
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        /**
+        * @brief In-place LU factorization with partial pivoting, PA = LU.
+        * @param n Order of the %matrix.
+        * @param a,lda Row-major %matrix and its row stride. On return holds U on
+        *              and above the diagonal and the unit-diagonal L below it.
+        * @param piv Receives @a n row indices; row k was swapped with row piv[k].
+        * @return true if a zero pivot was met (ie the %matrix is singular).
+        *
+        * On a singular %matrix the factorization stops at the zero pivot and
+        * the contents of a and piv are unspecified.
+        */
+        template <typename T>
+        bool lu_factor(size_t n, T* a, size_t lda, size_t* piv)
+        {
+            for (size_t k = 0; k < n; ++k) {
+                size_t p = k;
+                T best = std::abs(a[k * lda + k]);
+                for (size_t i = k + 1; i < n; ++i) {
+                    T v = std::abs(a[i * lda + k]);
+                    if (v > best) {
+                        best = v;
+                        p = i;
+                    }
+                }
+                piv[k] = p;
+                if (best == T(0)) {
+                    return true;
+                }
+                T* ak = a + k * lda;
+                if (p != k) {
+                    std::swap_ranges(ak, ak + n, a + p * lda);
+                }
+                T inv = T(1) / ak[k];
+                for (size_t i = k + 1; i < n; ++i) {
+                    T* ai = a + i * lda;
+                    T l = ai[k] *= inv;
+                    for (size_t j = k + 1; j < n; ++j) {
+                        ai[j] -= l * ak[j];
+                    }
+                }
+            }
+            return false;
+        }
+
+        /**
+        * @brief Solves A X = B in place given the output of lu_factor.
+        * @param n Order of A.
+        * @param lu,lda Factorization from lu_factor and its row stride.
+        * @param piv Pivot indices from lu_factor.
+        * @param b,ldb Row-major @a n * @a nrhs right-hand sides, overwritten with X.
+        * @param nrhs Number of right-hand side columns.
+        */
+        template <typename T>
+        void lu_solve(size_t n, const T* lu, size_t lda, const size_t* piv, T* b, size_t ldb, size_t nrhs)
+        {
+            for (size_t k = 0; k < n; ++k) {
+                if (piv[k] != k) {
+                    std::swap_ranges(b + k * ldb, b + k * ldb + nrhs, b + piv[k] * ldb);
+                }
+            }
+            for (size_t i = 1; i < n; ++i) {
+                T* bi = b + i * ldb;
+                for (size_t k = 0; k < i; ++k) {
+                    T l = lu[i * lda + k];
+                    const T* bk = b + k * ldb;
+                    for (size_t j = 0; j < nrhs; ++j) {
+                        bi[j] -= l * bk[j];
+                    }
+                }
+            }
+            for (size_t i = n; i-- > 0;) {
+                T* bi = b + i * ldb;
+                for (size_t k = i + 1; k < n; ++k) {
+                    T u = lu[i * lda + k];
+                    const T* bk = b + k * ldb;
+                    for (size_t j = 0; j < nrhs; ++j) {
+                        bi[j] -= u * bk[j];
+                    }
+                }
+                T inv = T(1) / lu[i * lda + i];
+                for (size_t j = 0; j < nrhs; ++j) {
+                    bi[j] *= inv;
+                }
+            }
+        }
+
+        /**
+        * @brief Fraction-free (Bareiss) elimination for exact determinants of integer matrices.
+        * @param n Order of the %matrix.
+        * @param a,lda Row-major %matrix and its row stride, destroyed.
+        * @return Determinant of the %matrix.
+        *
+        * Every division is exact, so intermediate values stay integral and
+        * bounded by the magnitude of the minors of the input.
+        */
+        template <typename T>
+        T bareiss_det(size_t n, T* a, size_t lda)
+        {
+            T prev = T(1);
+            bool negate = false;
+            for (size_t k = 0; k + 1 < n; ++k) {
+                T* ak = a + k * lda;
+                if (ak[k] == T(0)) {
+                    size_t p = k + 1;
+                    while (p < n && a[p * lda + k] == T(0)) {
+                        ++p;
+                    }
+                    if (p == n) {
+                        return T(0);
+                    }
+                    std::swap_ranges(ak, ak + n, a + p * lda);
+                    negate = !negate;
+                }
+                for (size_t i = k + 1; i < n; ++i) {
+                    T* ai = a + i * lda;
+                    for (size_t j = k + 1; j < n; ++j) {
+                        ai[j] = (ai[j] * ak[k] - ai[k] * ak[j]) / prev;
+                    }
+                }
+                prev = ak[k];
+            }
+            T d = a[(n - 1) * lda + (n - 1)];
+            return negate ? -d : d;
+        }
+
+        /**
+        * @brief Largest order for which the fixed-size factorizations are fully unrolled.
+        */
+        constexpr size_t unroll_limit = 6;
+
+        /**
+        * @brief Calls f with std::integral_constant indices B, B+1, ..., E-1, unrolled at compile time.
+        */
+        template <size_t B, size_t E, typename F>
+        inline void static_for(F&& f)
+        {
+            if constexpr (B < E) {
+                f(std::integral_constant<size_t, B>());
+                static_for<B + 1, E>(f);
+            }
+        }
+
+        /**
+        * @brief In-place Cholesky factorization A = L L^T of a symmetric positive definite %matrix.
+        * @param n Order of the %matrix.
+        * @param a,rs,cs %matrix and its row and column strides. Only the lower
+        *                triangle is read; it is overwritten with L. The strict
+        *                upper triangle is left untouched.
+        * @return true if the %matrix is not positive definite, in which case
+        *         the contents of a are unspecified.
+        */
+        template <typename T>
+        bool cholesky_factor(size_t n, T* a, size_t rs, size_t cs)
+        {
+            for (size_t j = 0; j < n; ++j) {
+                T* aj = a + j * rs;
+                T d = aj[j * cs];
+                for (size_t k = 0; k < j; ++k) {
+                    d -= aj[k * cs] * aj[k * cs];
+                }
+                if (!(d > T(0))) {
+                    return true;
+                }
+                T l = std::sqrt(d);
+                aj[j * cs] = l;
+                T r = T(1) / l;
+                for (size_t i = j + 1; i < n; ++i) {
+                    T* ai = a + i * rs;
+                    T acc = ai[j * cs];
+                    for (size_t k = 0; k < j; ++k) {
+                        acc -= ai[k * cs] * aj[k * cs];
+                    }
+                    ai[j * cs] = acc * r;
+                }
+            }
+            return false;
+        }
+
+        /**
+        * @brief Fully unrolled cholesky_factor for a compile-time order @a n.
+        */
+        template <size_t n, typename T>
+        bool cholesky_factor(T* a, size_t rs, size_t cs)
+        {
+            bool bad = false;
+            static_for<0, n>([&](auto jc) {
+                constexpr size_t j = decltype(jc)::value;
+                T d = a[j * rs + j * cs];
+                static_for<0, j>([&](auto kc) {
+                    constexpr size_t k = decltype(kc)::value;
+                    d -= a[j * rs + k * cs] * a[j * rs + k * cs];
+                });
+                bad |= !(d > T(0));
+                T l = std::sqrt(d);
+                a[j * rs + j * cs] = l;
+                T r = T(1) / l;
+                static_for<j + 1, n>([&](auto ic) {
+                    constexpr size_t i = decltype(ic)::value;
+                    T acc = a[i * rs + j * cs];
+                    static_for<0, j>([&](auto kc) {
+                        constexpr size_t k = decltype(kc)::value;
+                        acc -= a[i * rs + k * cs] * a[j * rs + k * cs];
+                    });
+                    a[i * rs + j * cs] = acc * r;
+                });
+            });
+            return bad;
+        }
+
+        /**
+        * @brief Solves L L^T X = B in place given the factor from cholesky_factor.
+        * @param n Order of L.
+        * @param l,rs,cs Lower triangular factor and its row and column strides.
+        * @param b,rsb,csb @a n * @a nrhs right-hand sides and their strides, overwritten with X.
+        * @param nrhs Number of right-hand side columns.
+        */
+        template <typename T>
+        void cholesky_solve(size_t n, const T* l, size_t rs, size_t cs, T* b, size_t rsb, size_t csb, size_t nrhs)
+        {
+            for (size_t c = 0; c < nrhs; ++c) {
+                T* x = b + c * csb;
+                for (size_t i = 0; i < n; ++i) {
+                    T acc = x[i * rsb];
+                    for (size_t k = 0; k < i; ++k) {
+                        acc -= l[i * rs + k * cs] * x[k * rsb];
+                    }
+                    x[i * rsb] = acc / l[i * rs + i * cs];
+                }
+                for (size_t i = n; i-- > 0;) {
+                    T acc = x[i * rsb];
+                    for (size_t k = i + 1; k < n; ++k) {
+                        acc -= l[k * rs + i * cs] * x[k * rsb];
+                    }
+                    x[i * rsb] = acc / l[i * rs + i * cs];
+                }
+            }
+        }
+
+        /**
+        * @brief Fully unrolled cholesky_solve for a compile-time order @a n.
+        */
+        template <size_t n, typename T>
+        void cholesky_solve(const T* l, size_t rs, size_t cs, T* b, size_t rsb, size_t csb, size_t nrhs)
+        {
+            T rdiag[n];
+            static_for<0, n>([&](auto ic) {
+                constexpr size_t i = decltype(ic)::value;
+                rdiag[i] = T(1) / l[i * rs + i * cs];
+            });
+            for (size_t c = 0; c < nrhs; ++c) {
+                T* x = b + c * csb;
+                static_for<0, n>([&](auto ic) {
+                    constexpr size_t i = decltype(ic)::value;
+                    T acc = x[i * rsb];
+                    static_for<0, i>([&](auto kc) {
+                        constexpr size_t k = decltype(kc)::value;
+                        acc -= l[i * rs + k * cs] * x[k * rsb];
+                    });
+                    x[i * rsb] = acc * rdiag[i];
+                });
+                static_for<0, n>([&](auto rc) {
+                    constexpr size_t i = n - 1 - decltype(rc)::value;
+                    T acc = x[i * rsb];
+                    static_for<i + 1, n>([&](auto kc) {
+                        constexpr size_t k = decltype(kc)::value;
+                        acc -= l[k * rs + i * cs] * x[k * rsb];
+                    });
+                    x[i * rsb] = acc * rdiag[i];
+                });
+            }
+        }
+
+        /**
+        * @brief Offset of row i of an order @a n upper triangle packed row by row.
+        *
+        * Row i holds elements i..n-1 of row i, so element i,j with i <= j is
+        * at packed_offset(n, i) + j - i.
+        */
+        constexpr size_t packed_offset(size_t n, size_t i)
+        {
+            return i * (2 * n - i + 1) / 2;
+        }
+
+        /**
+        * @brief Vectorized y += s * x over @a len contiguous elements.
+        */
+        template <typename T>
+        inline void axpy_n(size_t len, T s, const T* x, T* y)
+        {
+            typedef simd<T> V;
+            constexpr size_t w = V::width;
+            size_t k = 0;
+            if constexpr (w > 1) {
+                typename V::type vs = V::broadcast(s);
+                for (; k + w <= len; k += w) {
+                    V::store(y + k, V::fmadd(vs, V::load(x + k), V::load(y + k)));
+                }
+            }
+            for (; k < len; ++k) {
+                y[k] += s * x[k];
+            }
+        }
+
+        /**
+        * @brief Vectorized dot product of @a len contiguous elements.
+        */
+        template <typename T>
+        inline T dot_n(size_t len, const T* x, const T* y)
+        {
+            typedef simd<T> V;
+            constexpr size_t w = V::width;
+            size_t k = 0;
+            T acc = 0;
+            if constexpr (w > 1) {
+                typename V::type va = V::zero();
+                for (; k + w <= len; k += w) {
+                    va = V::fmadd(V::load(x + k), V::load(y + k), va);
+                }
+                T lanes[w];
+                V::store(lanes, va);
+                for (size_t l = 0; l < w; ++l) {
+                    acc += lanes[l];
+                }
+            }
+            for (; k < len; ++k) {
+                acc += x[k] * y[k];
+            }
+            return acc;
+        }
+
+        /**
+        * @brief In-place Cholesky factorization S = U^T U of a packed symmetric positive definite %matrix.
+        * @param n Order of the %matrix.
+        * @param u Packed upper triangle (see packed_offset), overwritten with U.
+        * @return true if the %matrix is not positive definite, in which case
+        *         the contents of u are unspecified.
+        *
+        * Right-looking: once row j of U is final, it is subtracted from each
+        * trailing row as one contiguous axpy_n, so the update runs along the
+        * packed rows.
+        */
+        template <typename T>
+        bool packed_cholesky_factor(size_t n, T* u)
+        {
+            for (size_t j = 0; j < n; ++j) {
+                T* uj = u + packed_offset(n, j);
+                if (!(uj[0] > T(0))) {
+                    return true;
+                }
+                T l = std::sqrt(uj[0]);
+                uj[0] = l;
+                T r = T(1) / l;
+                for (size_t c = 1; c < n - j; ++c) {
+                    uj[c] *= r;
+                }
+                for (size_t i = j + 1; i < n; ++i) {
+                    axpy_n(n - i, -uj[i - j], uj + (i - j), u + packed_offset(n, i));
+                }
+            }
+            return false;
+        }
+
+        /**
+        * @brief Fully unrolled packed_cholesky_factor for a compile-time order @a n.
+        */
+        template <size_t n, typename T>
+        bool packed_cholesky_factor(T* u)
+        {
+            bool bad = false;
+            static_for<0, n>([&](auto jc) {
+                constexpr size_t j = decltype(jc)::value;
+                T* uj = u + packed_offset(n, j);
+                bad |= !(uj[0] > T(0));
+                T l = std::sqrt(uj[0]);
+                uj[0] = l;
+                T r = T(1) / l;
+                static_for<1, n - j>([&](auto cc) {
+                    uj[decltype(cc)::value] *= r;
+                });
+                static_for<j + 1, n>([&](auto ic) {
+                    constexpr size_t i = decltype(ic)::value;
+                    T* ui = u + packed_offset(n, i);
+                    T s = uj[i - j];
+                    for (size_t c = 0; c < n - i; ++c) {
+                        ui[c] -= s * uj[i - j + c];
+                    }
+                });
+            });
+            return bad;
+        }
+
+        /**
+        * @brief Solves U^T Y = B in place given the factor from packed_cholesky_factor.
+        * @param n Order of U.
+        * @param u Packed factor.
+        * @param b,rsb @a n * @a nrhs right-hand sides with contiguous rows, overwritten with Y.
+        * @param nrhs Number of right-hand side columns.
+        */
+        template <typename T>
+        void packed_forward_solve(size_t n, const T* u, T* b, size_t rsb, size_t nrhs)
+        {
+            for (size_t i = 0; i < n; ++i) {
+                const T* ui = u + packed_offset(n, i);
+                T* bi = b + i * rsb;
+                T r = T(1) / ui[0];
+                for (size_t c = 0; c < nrhs; ++c) {
+                    bi[c] *= r;
+                }
+                for (size_t j = i + 1; j < n; ++j) {
+                    axpy_n(nrhs, -ui[j - i], bi, b + j * rsb);
+                }
+            }
+        }
+
+        /**
+        * @brief Fully unrolled packed_forward_solve for a compile-time order @a n and @a nrhs columns.
+        */
+        template <size_t n, size_t nrhs, typename T>
+        void packed_forward_solve(const T* u, T* b, size_t rsb)
+        {
+            static_for<0, n>([&](auto ic) {
+                constexpr size_t i = decltype(ic)::value;
+                const T* ui = u + packed_offset(n, i);
+                T* bi = b + i * rsb;
+                T r = T(1) / ui[0];
+                for (size_t c = 0; c < nrhs; ++c) {
+                    bi[c] *= r;
+                }
+                static_for<i + 1, n>([&](auto jc) {
+                    constexpr size_t j = decltype(jc)::value;
+                    T* bj = b + j * rsb;
+                    for (size_t c = 0; c < nrhs; ++c) {
+                        bj[c] -= ui[j - i] * bi[c];
+                    }
+                });
+            });
+        }
+
+        /**
+        * @brief Solves U X = Y in place given the factor from packed_cholesky_factor.
+        * @param n Order of U.
+        * @param u Packed factor.
+        * @param b,rsb @a n * @a nrhs right-hand sides with contiguous rows, overwritten with X.
+        * @param nrhs Number of right-hand side columns.
+        */
+        template <typename T>
+        void packed_backward_solve(size_t n, const T* u, T* b, size_t rsb, size_t nrhs)
+        {
+            for (size_t i = n; i-- > 0;) {
+                const T* ui = u + packed_offset(n, i);
+                T* bi = b + i * rsb;
+                for (size_t j = i + 1; j < n; ++j) {
+                    axpy_n(nrhs, -ui[j - i], b + j * rsb, bi);
+                }
+                T r = T(1) / ui[0];
+                for (size_t c = 0; c < nrhs; ++c) {
+                    bi[c] *= r;
+                }
+            }
+        }
+
+        /**
+        * @brief Fully unrolled packed_backward_solve for a compile-time order @a n and @a nrhs columns.
+        */
+        template <size_t n, size_t nrhs, typename T>
+        void packed_backward_solve(const T* u, T* b, size_t rsb)
+        {
+            static_for<0, n>([&](auto rc) {
+                constexpr size_t i = n - 1 - decltype(rc)::value;
+                const T* ui = u + packed_offset(n, i);
+                T* bi = b + i * rsb;
+                static_for<i + 1, n>([&](auto jc) {
+                    constexpr size_t j = decltype(jc)::value;
+                    const T* bj = b + j * rsb;
+                    for (size_t c = 0; c < nrhs; ++c) {
+                        bi[c] -= ui[j - i] * bj[c];
+                    }
+                });
+                T r = T(1) / ui[0];
+                for (size_t c = 0; c < nrhs; ++c) {
+                    bi[c] *= r;
+                }
+            });
+        }
+
+        /**
+        * @brief Symmetric rank-k update C = alpha * A^T A + beta * C on a packed C.
+        * @param n Order of C.
+        * @param k Number of rows of A.
+        * @param a,rsa @a k * @a n %matrix A with contiguous rows, and its row stride.
+        * @param c Packed upper triangle of C. If beta is zero, c is not read.
+        *
+        * Row i of C is A(p,i) times row p of A from column i on, summed over
+        * p in vector registers, so only the stored triangle is computed and
+        * both operands are read along contiguous rows.
+        */
+        template <typename T>
+        void packed_syrk(size_t n, size_t k, T alpha, const T* a, size_t rsa, T beta, T* c)
+        {
+            typedef simd<T> V;
+            typedef typename V::type vec;
+            constexpr size_t w = V::width;
+            for (size_t i = 0; i < n; ++i) {
+                T* ci = c + packed_offset(n, i) - i;
+                size_t j = i;
+                if constexpr (w > 1) {
+                    vec va = V::broadcast(alpha);
+                    vec vb = V::broadcast(beta);
+                    for (; j + w <= n; j += w) {
+                        vec acc = V::zero();
+                        for (size_t p = 0; p < k; ++p) {
+                            const T* ap = a + p * rsa;
+                            acc = V::fmadd(V::broadcast(ap[i]), V::load(ap + j), acc);
+                        }
+                        if (beta == T(0)) {
+                            V::store(ci + j, V::mul(va, acc));
+                        } else {
+                            V::store(ci + j, V::fmadd(va, acc, V::mul(vb, V::load(ci + j))));
+                        }
+                    }
+                }
+                for (; j < n; ++j) {
+                    T acc = 0;
+                    for (size_t p = 0; p < k; ++p) {
+                        acc += a[p * rsa + i] * a[p * rsa + j];
+                    }
+                    ci[j] = beta == T(0) ? alpha * acc : alpha * acc + beta * ci[j];
+                }
+            }
+        }
+
+        /**
+        * @brief Fully unrolled packed_syrk for a compile-time order @a n and @a k rows of A.
+        */
+        template <size_t n, size_t k, typename T>
+        void packed_syrk(T alpha, const T* a, size_t rsa, T beta, T* c)
+        {
+            static_for<0, n>([&](auto ic) {
+                constexpr size_t i = decltype(ic)::value;
+                T* ci = c + packed_offset(n, i);
+                for (size_t j = 0; j < n - i; ++j) {
+                    ci[j] = beta == T(0) ? T(0) : beta * ci[j];
+                }
+                for (size_t p = 0; p < k; ++p) {
+                    const T* ap = a + p * rsa + i;
+                    T s = alpha * ap[0];
+                    for (size_t j = 0; j < n - i; ++j) {
+                        ci[j] += s * ap[j];
+                    }
+                }
+            });
+        }
+
+        /**
+        * @brief Fully unrolled packed_symv for a compile-time order @a n.
+        */
+        template <size_t n, typename T>
+        void packed_symv(T alpha, const T* s, const T* x, T beta, T* y)
+        {
+            T acc[n];
+            for (size_t i = 0; i < n; ++i) {
+                acc[i] = 0;
+            }
+            static_for<0, n>([&](auto ic) {
+                constexpr size_t i = decltype(ic)::value;
+                const T* si = s + packed_offset(n, i);
+                T dot = si[0] * x[i];
+                for (size_t j = 1; j < n - i; ++j) {
+                    dot += si[j] * x[i + j];
+                    acc[i + j] += si[j] * x[i];
+                }
+                acc[i] += dot;
+            });
+            for (size_t i = 0; i < n; ++i) {
+                y[i] = beta == T(0) ? alpha * acc[i] : alpha * acc[i] + beta * y[i];
+            }
+        }
+
+        /**
+        * @brief Symmetric %matrix-vector product y = alpha * S x + beta * y on a packed S.
+        * @param n Order of S.
+        * @param s Packed upper triangle of S.
+        * @param x,y Contiguous vectors of @a n elements that do not overlap.
+        *            If beta is zero, y is not read.
+        *
+        * Each packed row is read once: as a dot product with x for the
+        * upper triangle and the diagonal, and as an axpy into y for the
+        * lower triangle it mirrors.
+        */
+        template <typename T>
+        void packed_symv(size_t n, T alpha, const T* s, const T* x, T beta, T* y)
+        {
+            for (size_t i = 0; i < n; ++i) {
+                y[i] = beta == T(0) ? T(0) : beta * y[i];
+            }
+            for (size_t i = 0; i < n; ++i) {
+                const T* si = s + packed_offset(n, i);
+                y[i] += alpha * dot_n(n - i, si, x + i);
+                axpy_n(n - i - 1, alpha * x[i], si + 1, y + i + 1);
+            }
+        }
+    }
+}
+
+#endif // __KERNELS_HH__
@@ -1,71 +1,57 @@
 #ifndef __MATRIX_HH__
 #define __MATRIX_HH__
 
+#include <cassert>
 #include <memory>
 #include <iostream>
 #include <functional>
 #include <algorithm>
+#include <utility>
+#include <type_traits>
+#include <limits>
+#include <cmath>
+
+#include "gabp/kernels.hh"
 
 /**
  * @brief The %gmat namespace includes the linear algebra backend for GaBP.
  */
 namespace gmat {
     /**
-    * @brief %matrix class for linear algebra behind inference algorithms.
+    * @brief Static-dispatch base of every %gmat %matrix type.
+    * @tparam D Concrete %matrix type deriving from this class (CRTP).
     * @tparam T Type of elements.
     * @tparam m Number of rows.
     * @tparam n Number of columns.
+    *
+    * Algorithms take their operands as %static_matrix references and reach the
+    * elements through derived(), so the accessors of the concrete type are
+    * resolved at compile time and can be inlined into the loops. Types that
+    * need runtime polymorphism go through the %matrix interface instead.
+    *
+    * Every concrete type defines get(i, j); writable types also define
+    * set(i, j, value). The base declares neither, so writing to a read-only
+    * type such as an expression fails to compile.
     */
-    template <typename T, size_t m, size_t n>
-    class matrix {
+    template <typename D, typename T, size_t m, size_t n>
+    class static_matrix {
     public:
-        /**
-        * @brief Gets the value of the element at coordinate i,j.
-        * @param i Row coordinate.
-        * @param j Column coordinate.
-        * @return Value at i,j.
-        *
-        * @pre i < m
-        * @pre j < n
-        */
-        virtual T get(size_t i, size_t j) const;
-
-        /**
-        * @brief Sets the value of the element at coordinate i,j.
-        * @param i Row coordinate.
-        * @param j Column coordinate.
-        * @param value Value to be set.
-        * @return New value.
-        *
-        * @pre i < m
-        * @pre j < n
-        */
-        virtual T set(size_t i, size_t j, T value);
+        typedef T value_type;
+        static constexpr size_t rows = m;
+        static constexpr size_t cols = n;
 
         /**
-        * @brief Left %matrix multiplication.
-        * @tparam o The width of the right %matrix.
-        * @param right An @a n*o %matrix.
-        * @return The @a m*o product of this @a m*n %matrix and the right @a n*o %matrix supplied.
+        * @brief Downcasts to the concrete %matrix type.
+        * @return Reference to this object as a D.
         */
-        template <size_t o>
-        std::shared_ptr<matrix<T, m, o>> operator*(matrix<T, n, o>& right)
+        D& derived()
         {
-            auto ret = std::make_shared<matrix<T, m, o>>();
-            matmul(this, right, *ret);
-            return ret;
+            return static_cast<D&>(*this);
         }
 
-        /**
-        * @brief Entryise %matrix summation.
-        * @param right Another @a m*n %matrix.
-        * @return The @a m*n sum of this @a m*n %matrix and the right @a m*n %matrix supplied.
-        */
-        std::shared_ptr<matrix<T, m, n>> operator+(matrix<T, m, n>& right)
+        const D& derived() const
         {
-            auto ret = std::make_shared<matrix<T, m, n>>();
-            matadd(this, right, *ret);
-            return ret;
+            return static_cast<const D&>(*this);
         }
 
         /**
@@ -78,11 +64,12 @@ namespace gmat {
          *          floating point matrices. Use comppred with a thresholding predicate
          *          instead.
          */
-        bool operator==(matrix<T, m, n>& right)
+        template <typename R>
+        bool operator==(const static_matrix<R, T, m, n>& right) const
         {
-            for (int i = 0; i < m; ++i) {
-                for (int j = 0; j < n; ++j) {
-                    if (this->get(i, j) != right.get(i, j)) {
+            for (size_t i = 0; i < m; ++i) {
+                for (size_t j = 0; j < n; ++j) {
+                    if (derived().get(i, j) != right.derived().get(i, j)) {
                         return false;
                     }
                 }
@@ -97,11 +84,12 @@ namespace gmat {
          * @return true if each entry of the two matrices pass the predicate.
          *         false if any entry of the two matrices fails the predicate.
          */
-        bool cmppred(matrix<T, m, n>& right, std::function<bool(T, T)> pred)
+        template <typename R>
+        bool cmppred(const static_matrix<R, T, m, n>& right, std::function<bool(T, T)> pred) const
         {
-            for (int i = 0; i < m; ++i) {
-                for (int j = 0; j < n; ++j) {
-                    if (!pred(this->get(i, j), right.get(i, j))) {
+            for (size_t i = 0; i < m; ++i) {
+                for (size_t j = 0; j < n; ++j) {
+                    if (!pred(derived().get(i, j), right.derived().get(i, j))) {
                         return false;
                     }
                 }
@@ -109,37 +97,327 @@ namespace gmat {
             return true;
         }
 
-        friend std::ostream& operator<<(std::ostream&out, const matrix<T, m, n>& mat)
+        friend std::ostream& operator<<(std::ostream&out, const static_matrix<D, T, m, n>& mat)
         {
+            const D& d = mat.derived();
             out << "[ ";
             for (size_t j = 0; j < n; ++j) {
-                out << "\t" << mat.get(0, j);
+                out << "\t" << d.get(0, j);
             }
             for (size_t i = 1; i < m; ++i) {
                 out << "\n  ";
                 for (size_t j = 0; j < n; ++j) {
-                    out << "\t" << mat.get(i, j);
+                    out << "\t" << d.get(i, j);
                 }
             }
             out << "\t ]\n";
             return out;
         }
 
-    private:
         /**
-         * @brief Calculates the address of an element.
-         * @param i 
-         * @param j 
-         * @return Pointer to element.
-         */
-        // virtual T* address(size_t i, size_t j);
+        * @brief Checks whether evaluating this %matrix may read memory in a range.
+        * @param lo First byte of the range.
+        * @param hi One past the last byte of the range.
+        * @return true unless the %matrix is known not to read from [lo, hi).
+        *
+        * Used to decide whether an expression can be written straight into its
+        * destination. Types that cannot tell answer true.
+        */
+        bool aliases(const void*, const void*) const
+        {
+            return true;
+        }
+
+    protected:
+        static_matrix() = default;
+        static_matrix(const static_matrix&) = default;
+        static_matrix& operator=(const static_matrix&) = default;
+    };
+
+    /**
+    * @brief Tag base of the lazy expression types.
+    *
+    * Expressions are cheap to copy and are held by value inside enclosing
+    * expressions; everything else is held by reference.
+    */
+    struct expression { };
+
+    /**
+    * @brief Tag base of the zero-copy adaptors, %transpose_view and %symmetric_view.
+    *
+    * Adaptors are held by value inside expressions, like expressions, but
+    * are never evaluated into a temporary: they only hold a reference.
+    */
+    struct adaptor { };
+
+    template <typename L, typename R>
+    class product_expr;
+
+    template <typename M>
+    class transpose_view;
+
+    template <typename M>
+    class symmetric_view;
+
+    namespace detail {
+        template <typename D, typename S, typename T, size_t m, size_t n>
+        void assign_unaliased(static_matrix<D, T, m, n>& dest, const static_matrix<S, T, m, n>& src);
+
+        template <typename X>
+        struct is_product : std::false_type { };
+
+        template <typename L, typename R>
+        struct is_product<product_expr<L, R>> : std::true_type { };
+
+        template <typename X>
+        struct is_transpose : std::false_type { };
+
+        template <typename M>
+        struct is_transpose<transpose_view<M>> : std::true_type { };
+
+        template <typename X>
+        struct is_symmetric : std::false_type { };
+
+        template <typename M>
+        struct is_symmetric<symmetric_view<M>> : std::true_type { };
+
+        /**
+        * @brief True for %matrix types that expose strided storage through data(), row_stride() and col_stride().
+        */
+        template <typename X, typename = void>
+        struct has_storage : std::false_type { };
+
+        template <typename X>
+        struct has_storage<X, std::void_t<decltype(std::declval<const X&>().data()),
+                                          decltype(std::declval<const X&>().row_stride()),
+                                          decltype(std::declval<const X&>().col_stride())>> : std::true_type { };
+
+        /**
+        * @brief True for %matrix types that define set(), i.e. that can be assigned to.
+        */
+        template <typename X, typename = void>
+        struct is_writable : std::false_type { };
+
+        template <typename X>
+        struct is_writable<X, std::void_t<decltype(std::declval<X&>().set(0, 0, std::declval<typename X::value_type>()))>>
+            : std::true_type { };
+
+        /**
+        * @brief True for symmetric %matrix types that store only their upper triangle, marked by a static member upper_stored.
+        *
+        * Entrywise algorithms write only j >= i of such a destination, so
+        * that each stored element is updated once.
+        */
+        template <typename X, typename = void>
+        struct stores_upper : std::false_type { };
+
+        template <typename X>
+        struct stores_upper<X, std::enable_if_t<X::upper_stored>> : std::true_type { };
+
+        /**
+        * @brief First column of row i that an entrywise algorithm writes in a destination of type X.
+        */
+        template <typename X>
+        constexpr size_t first_written(size_t i)
+        {
+            return stores_upper<X>::value ? i : 0;
+        }
+
+        /**
+        * @brief Where the elements of a %matrix live in strided storage, possibly as a window that wraps around a larger array.
+        *
+        * Element r,c lives at origin[((i + r) % rows) * rs + ((j + c) % cols) * cs],
+        * where rows and cols are the dimensions of the underlying array and
+        * i < rows, j < cols. A null origin means the elements are not addressable.
+        */
+        template <typename T>
+        struct strided_layout {
+            T* origin;
+            size_t rs, cs;
+            size_t rows, cols;
+            size_t i, j;
+
+            /**
+            * @brief Number of columns before the right edge of the underlying array.
+            */
+            size_t split() const
+            {
+                return cols - j;
+            }
+
+            /**
+            * @brief Column of the underlying array holding column c.
+            */
+            size_t column(size_t c) const
+            {
+                return c < split() ? j + c : c - split();
+            }
+
+            /**
+            * @brief One past the last element of the underlying array.
+            */
+            T* end() const
+            {
+                return origin + (rows - 1) * rs + (cols - 1) * cs + 1;
+            }
+        };
+
+        /**
+        * @brief True for %matrix types that describe their storage through layout(), such as %submatrix.
+        */
+        template <typename X, typename = void>
+        struct has_layout : std::false_type { };
+
+        template <typename X>
+        struct has_layout<X, std::void_t<decltype(std::declval<const X&>().layout())>> : std::true_type { };
+
+        template <typename X>
+        using operand_t = typename std::conditional<std::is_base_of<expression, X>::value || std::is_base_of<adaptor, X>::value,
+                                                    const X, const X&>::type;
+    }
+
+    template <typename T, size_t m, size_t n>
+    class basematrix;
+
+    template <typename M>
+    class erased;
+
+    template <typename T, size_t m, size_t n>
+    class matrix_view;
+
+    /**
+    * @brief Type-erased %matrix interface for linear algebra behind inference algorithms.
+    * @tparam T Type of elements.
+    * @tparam m Number of rows.
+    * @tparam n Number of columns.
+    *
+    * Every access goes through a virtual call. Use it where the concrete type is
+    * only known at runtime; wrap a static %matrix in %erased to obtain one.
+    *
+    * @note %basematrix does not derive from this interface. Where a
+    *       %basematrix used to be held through std::shared_ptr<matrix>,
+    *       make an erased<basematrix> instead.
+    */
+    template <typename T, size_t m, size_t n>
+    class matrix : public static_matrix<matrix<T, m, n>, T, m, n> {
+    public:
+        virtual ~matrix() = default;
+
+        /**
+        * @brief Gets the value of the element at coordinate i,j.
+        * @param i Row coordinate.
+        * @param j Column coordinate.
+        * @return Value at i,j.
+        *
+        * @pre i < m
+        * @pre j < n
+        */
+        virtual T get(size_t i, size_t j) const = 0;
+
+        /**
+        * @brief Sets the value of the element at coordinate i,j.
+        * @param i Row coordinate.
+        * @param j Column coordinate.
+        * @param value Value to be set.
+        * @return New value.
+        *
+        * @pre i < m
+        * @pre j < n
+        */
+        virtual T set(size_t i, size_t j, T value) = 0;
+
+        /**
+        * @brief Checks whether evaluating this %matrix may read memory in a range.
+        * @param lo First byte of the range.
+        * @param hi One past the last byte of the range.
+        * @return true unless the %matrix is known not to read from [lo, hi).
+        */
+        virtual bool aliases(const void*, const void*) const
+        {
+            return true;
+        }
+
+        /**
+        * @brief Describes the strided storage behind this %matrix, if there is one.
+        * @param rs Receives the distance between vertically adjacent elements.
+        * @param cs Receives the distance between horizontally adjacent elements.
+        * @return Pointer to element 0,0, or nullptr if the elements are not
+        *         addressable; rs and cs are then unchanged.
+        */
+        virtual T* storage(size_t&, size_t&)
+        {
+            return nullptr;
+        }
+    };
+
+    /**
+    * @brief Adapts any static %matrix type to the type-erased %matrix interface.
+    * @tparam M Static %matrix type to wrap, held by value.
+    */
+    template <typename M>
+    class erased : public matrix<typename M::value_type, M::rows, M::cols> {
+        static_assert(detail::is_writable<M>::value, "erased requires a writable matrix type");
+
+    public:
+        typedef typename M::value_type T;
+
+        /**
+        * @brief Creates an %erased object, constructing the wrapped %matrix in place.
+        * @param args Arguments forwarded to the constructor of M.
+        */
+        template <typename... Args>
+        explicit erased(Args&&... args) : m_inner(std::forward<Args>(args)...) { }
+
+        T get(size_t i, size_t j) const override
+        {
+            return m_inner.get(i, j);
+        }
+
+        T set(size_t i, size_t j, T value) override
+        {
+            return m_inner.set(i, j, value);
+        }
+
+        bool aliases(const void* lo, const void* hi) const override
+        {
+            return m_inner.aliases(lo, hi);
+        }
+
+        T* storage(size_t& rs, size_t& cs) override
+        {
+            if constexpr (detail::has_storage<M>::value) {
+                if constexpr (std::is_same<decltype(m_inner.data()), T*>::value) {
+                    rs = m_inner.row_stride();
+                    cs = m_inner.col_stride();
+                    return m_inner.data();
+                }
+            }
+            return nullptr;
+        }
+
+        /**
+        * @brief Accesses the wrapped %matrix with its static type.
+        * @return Reference to the wrapped %matrix.
+        */
+        M& inner()
+        {
+            return m_inner;
+        }
+
+        const M& inner() const
+        {
+            return m_inner;
+        }
+
+    private:
+        M m_inner;
     };
 
-    template <typename T, size_t m, size_t n, size_t M, size_t N>
+    template <typename T, size_t m, size_t n, size_t M, size_t N, typename P>
     class submatrix;
 
     template <typename T, size_t m, size_t n>
-    class basematrix : public matrix<T, m, n> {
+    class basematrix : public static_matrix<basematrix<T, m, n>, T, m, n> {
     public:
         /**
         * @brief Creates a %basematrix object.
@@ -177,27 +455,55 @@ namespace gmat {
         */
         basematrix(const basematrix<T, m ,n>& other)
         {
-            std::copy_n(other.m_elements, m * n, this->m_elements);
+            std::copy_n((const T*) other.m_elements, m * n, (T*) this->m_elements);
         };
 
+        basematrix& operator=(const basematrix<T, m, n>& other)
+        {
+            std::copy_n((const T*) other.m_elements, m * n, (T*) this->m_elements);
+            return *this;
+        }
+
         /**
         * @brief %basematrix constructor from a submatrix.
         * @param other Existing %submatrix of identical element type and dimensions.
-        * 
-        * @todo Optimize this by copying rows or half-rows (need to 
-        *       split if the submatrix wraps)
+        *
+        * If the parent's storage is addressable, each row is copied in bulk,
+        * as two segments split at the right edge of the parent when the
+        * %submatrix wraps. See assign().
         */
-        template<size_t M, size_t N>
-        basematrix(const submatrix<T, m , n, M, N>& other)
+        template<size_t M, size_t N, typename P>
+        basematrix(const submatrix<T, m , n, M, N, P>& other)
         {
-            //T* address = other->address(0, 0);
-            for (int i = 0; i < m; ++i) {
-                for (int j = 0; j < n; ++j) {
-                    this->m_elements[i][j] = other.get(i, j);
-                }
-            }
+            detail::assign_unaliased(*this, other);
         };
 
+        /**
+        * @brief Creates a %basematrix object by evaluating any %matrix or expression.
+        * @param expr %matrix or lazy expression of identical element type and dimensions.
+        */
+        template <typename E>
+        basematrix(const static_matrix<E, T, m, n>& expr)
+        {
+            detail::assign_unaliased(*this, expr);
+        }
+
+        /**
+        * @brief Evaluates a %matrix or expression into this %basematrix.
+        * @param expr %matrix or lazy expression of identical element type and dimensions.
+        * @return Reference to this %basematrix.
+        *
+        * The expression is written straight into the elements in one pass, unless
+        * it reads from this %basematrix, in which case it is first evaluated into
+        * a temporary on the stack.
+        */
+        template <typename E>
+        basematrix& operator=(const static_matrix<E, T, m, n>& expr)
+        {
+            assign(*this, expr);
+            return *this;
+        }
+
         /**
         * @brief Gets the value of the element at coordinate i,j.
         * @param i Row coordinate.
@@ -207,7 +513,7 @@ namespace gmat {
         * @pre i < m
         * @pre j < n
         */
-        T get(size_t i, size_t j) const override
+        T get(size_t i, size_t j) const
         {
             return m_elements[i][j];
         }
@@ -222,20 +528,47 @@ namespace gmat {
         * @pre i < m
         * @pre j < n
         */
-        T set(size_t i, size_t j, T value) override
+        T set(size_t i, size_t j, T value)
         {
             return m_elements[i][j] = value;
         }
 
-        template<size_t sm, size_t sn>
-        submatrix<T, sm, sn, m, n> submatrix(size_t i, size_t j);
+        /**
+        * @brief Raw pointer to the row-major element storage.
+        * @return Pointer to element 0,0.
+        */
+        T* data()
+        {
+            return &m_elements[0][0];
+        }
 
-    private:
-        // T* address(size_t i, size_t j) override
-        // {
-        //     return &m_elements[i][j];
-        // }
+        const T* data() const
+        {
+            return &m_elements[0][0];
+        }
+
+        /**
+        * @brief Distance between vertically adjacent elements in data().
+        */
+        size_t row_stride() const
+        {
+            return n;
+        }
+
+        /**
+        * @brief Distance between horizontally adjacent elements in data().
+        */
+        size_t col_stride() const
+        {
+            return 1;
+        }
+
+        bool aliases(const void* lo, const void* hi) const
+        {
+            return lo < (const void*) (m_elements + m) && (const void*) m_elements < hi;
+        }
 
+    private:
         /**
         * @brief 2-dimensional @a m*n array containing all elements of the %basematrix.
         */
@@ -249,15 +582,33 @@ namespace gmat {
      * @tparam n Number of columns in %submatrix.
      * @tparam M Number of rows in original %matrix.
      * @tparam N Number of columns in original %matrix.
+     * @tparam P Type of the original %matrix. Defaults to the type-erased
+     *           interface; pass the concrete type to resolve accesses statically.
+     *
+     * Whether the window wraps is decided once, at construction. A window
+     * that does not wrap skips the modulo on every access, and if the parent
+     * also has strided storage (statically through detail::has_storage, or
+     * through matrix::storage() behind the type-erased interface) the
+     * %submatrix is contiguous: it caches a base pointer and the parent's
+     * strides, accesses become plain loads and stores, and view() hands the
+     * window to bulk algorithms as a %matrix_view. A wrapping window keeps
+     * the modulo on both coordinates.
+     *
+     * The pointer is deliberately not named data(), so that detail::has_storage
+     * stays false for %submatrix and generic kernels do not take the strided
+     * path on a window that wraps; check contiguous() and use view() instead.
      */
-    template <typename T, size_t m, size_t n, size_t M, size_t N>
-    class submatrix : public matrix<T, m, n> {
+    template <typename T, size_t m, size_t n, size_t M, size_t N, typename P = matrix<T, M, N>>
+    class submatrix : public static_matrix<submatrix<T, m, n, M, N, P>, T, m, n> {
     public:
         /**
          * @brief Creates a %submatrix object that directly mirrors a matrix.
          * @param mat %shared_ptr to the %matrix to be shadowed.
          */
-        submatrix(std::shared_ptr<matrix<T, M, N>> mat) : m_parent(mat), m_i(0), m_j(0) { }
+        submatrix(std::shared_ptr<P> mat) : m_parent(mat), m_i(0), m_j(0)
+        {
+            locate();
+        }
 
         /**
          * @brief Creates a %submatrix object that directly mirrors a matrix.
@@ -265,63 +616,742 @@ namespace gmat {
          * @param i Vertical offset from top of %matrix.
          * @param j Horizontal offset from left of %matrix.
          */
-        submatrix(std::shared_ptr<matrix<T, M, N>> mat, size_t i, size_t j) : m_parent(mat), m_i(i), m_j(j) { }
+        submatrix(std::shared_ptr<P> mat, size_t i, size_t j) : m_parent(mat), m_i(i), m_j(j)
+        {
+            locate();
+        }
 
-        T get(size_t i, size_t j) const override
+        T get(size_t i, size_t j) const
         {
+            if (m_base) {
+                return m_base[i * m_rs + j * m_cs];
+            }
+            if (!m_wraps) {
+                return m_parent->get(i + m_i, j + m_j);
+            }
             return m_parent->get((i + m_i) % M, (j + m_j) % N);
         };
 
-        T set(size_t i, size_t j, T value) override
+        T set(size_t i, size_t j, T value)
         {
+            if (m_base) {
+                return m_base[i * m_rs + j * m_cs] = value;
+            }
+            if (!m_wraps) {
+                return m_parent->set(i + m_i, j + m_j, value);
+            }
             return m_parent->set((i + m_i) % M, (j + m_j) % N, value);
         };
 
-    private:
-        // T* address(size_t i, size_t j) override
-        // {
-        //     return m_parent->address((i + m_i) % M, (j + m_j) % N);
-        // }
-
-        std::shared_ptr<matrix<T, M, N>> m_parent;
-        size_t m_i, m_j;
-    };
+        bool aliases(const void* lo, const void* hi) const
+        {
+            return m_parent->aliases(lo, hi);
+        }
 
-    /**
-    * @brief Calculates the determinant of the %matrix.
-    * @tparam T Type of elements.
-    * @tparam n Number of rows and number of columns.
-    * @param mat Shared pointer to %matrix to calculate determinant of.
-    * @return Determinant of type T.
-    */
-    template <typename T, size_t n>
-    T det(std::shared_ptr<matrix<T, n, n>> mat)
-    {
-        T acc = 0;
-        bool plus = true;
-        for (int j = 0; j < n; ++j) {
-            std::shared_ptr<matrix<T, n - 1, n - 1>> sub = std::make_shared<submatrix<T, n - 1, n - 1, n, n>>(mat, 1, j + 1);
-            auto sd = det(sub);
-            if (plus) {
-                acc += mat->get(0, j) * sd;
-            } else {
-                acc -= mat->get(0, j) * sd;
-            }
-            plus = !plus;
+        /**
+         * @brief Whether the window crosses the bottom or right edge of the parent and wraps around.
+         */
+        bool wraps() const
+        {
+            return m_wraps;
         }
-        return acc;
-    }
 
-    template <typename T>
-    T det(std::shared_ptr<matrix<T, 1, 1>>& mat)
-    {
-        return mat->get(0, 0);
-    }
+        /**
+         * @brief Whether the window does not wrap and its elements are addressable through base().
+         */
+        bool contiguous() const
+        {
+            return m_base != nullptr;
+        }
 
-    /**
-    * @brief Calculates the %inverse of a square %matrix and writes it into dest.
+        /**
+         * @brief Pointer to element 0,0 of the window in the parent's storage, or nullptr unless contiguous().
+         */
+        T* base() const
+        {
+            return m_base;
+        }
+
+        /**
+         * @brief Distance between vertically adjacent elements in base().
+         */
+        size_t row_stride() const
+        {
+            return m_rs;
+        }
+
+        /**
+         * @brief Distance between horizontally adjacent elements in base().
+         */
+        size_t col_stride() const
+        {
+            return m_cs;
+        }
+
+        /**
+         * @brief The window as a %matrix_view over the parent's storage.
+         * @pre contiguous()
+         */
+        matrix_view<T, m, n> view() const
+        {
+            assert(m_base);
+            return matrix_view<T, m, n>(m_base, m_rs, m_cs);
+        }
+
+        /**
+         * @brief Where the window lives in the parent's storage, wrapping included.
+         *
+         * The origin is null if the parent's storage is not addressable.
+         */
+        detail::strided_layout<T> layout() const
+        {
+            return {m_origin, m_rs, m_cs, M, N, m_i % M, m_j % N};
+        }
+
+    private:
+        void locate()
+        {
+            m_wraps = m_i + m > M || m_j + n > N;
+            m_origin = nullptr;
+            m_base = nullptr;
+            m_rs = 0;
+            m_cs = 0;
+            if constexpr (detail::has_storage<P>::value) {
+                if constexpr (std::is_same<decltype(m_parent->data()), T*>::value) {
+                    m_origin = m_parent->data();
+                    m_rs = m_parent->row_stride();
+                    m_cs = m_parent->col_stride();
+                }
+            } else if constexpr (std::is_base_of<matrix<T, M, N>, P>::value) {
+                m_origin = m_parent->storage(m_rs, m_cs);
+            }
+            if (m_origin && !m_wraps) {
+                m_base = m_origin + m_i * m_rs + m_j * m_cs;
+            }
+        }
+
+        std::shared_ptr<P> m_parent;
+        size_t m_i, m_j;
+
+        /**
+         * @brief Element 0,0 of the parent and of the window, and the parent's strides.
+         *
+         * m_origin is set whenever the parent's storage is addressable,
+         * m_base only if the window is also contiguous.
+         */
+        T* m_origin;
+        T* m_base;
+        size_t m_rs, m_cs;
+        bool m_wraps;
+    };
+
+    /**
+     * @brief Non-owning %matrix over external memory, addressed by a pointer and two strides.
+     * @tparam T Type of elements; const-qualify it for a read-only view.
+     * @tparam m Number of rows.
+     * @tparam n Number of columns.
+     *
+     * Element i,j lives at ptr[i * row_stride + j * col_stride]. Nothing is
+     * copied on construction, so a %matrix_view can sit directly on user
+     * arrays or mmapped buffers and be passed to every %gmat algorithm.
+     * Copying a view copies the pointer; assigning to a view writes the
+     * elements it refers to.
+     */
+    template <typename T, size_t m, size_t n>
+    class matrix_view : public static_matrix<matrix_view<T, m, n>, typename std::remove_const<T>::type, m, n> {
+    public:
+        typedef typename std::remove_const<T>::type value_type;
+
+        /**
+         * @brief Creates a %matrix_view of a dense row-major @a m*n array.
+         * @param ptr Pointer to element 0,0.
+         */
+        matrix_view(T* ptr) : m_ptr(ptr), m_rs(n), m_cs(1) { }
+
+        /**
+         * @brief Creates a %matrix_view of strided memory.
+         * @param ptr Pointer to element 0,0.
+         * @param row_stride Distance in elements between vertically adjacent elements.
+         * @param col_stride Distance in elements between horizontally adjacent elements.
+         */
+        matrix_view(T* ptr, size_t row_stride, size_t col_stride = 1) : m_ptr(ptr), m_rs(row_stride), m_cs(col_stride) { }
+
+        /**
+         * @brief Creates a %matrix_view of all elements of a %basematrix.
+         * @param mat %basematrix to view.
+         */
+        template <typename B, typename = typename std::enable_if<std::is_same<typename std::remove_const<B>::type,
+                                                                            basematrix<value_type, m, n>>::value>::type>
+        matrix_view(B& mat) : m_ptr(mat.data()), m_rs(n), m_cs(1) { }
+
+        matrix_view(const matrix_view& other) = default;
+
+        /**
+         * @brief Copies the elements of another view into the elements of this one.
+         */
+        matrix_view& operator=(const matrix_view& other)
+        {
+            return *this = static_cast<const static_matrix<matrix_view, value_type, m, n>&>(other);
+        }
+
+        /**
+         * @brief Evaluates a %matrix or expression into the viewed elements.
+         * @param expr %matrix or lazy expression of identical element type and dimensions.
+         * @return Reference to this %matrix_view.
+         */
+        template <typename E>
+        matrix_view& operator=(const static_matrix<E, value_type, m, n>& expr)
+        {
+            assign(*this, expr);
+            return *this;
+        }
+
+        value_type get(size_t i, size_t j) const
+        {
+            return m_ptr[i * m_rs + j * m_cs];
+        }
+
+        value_type set(size_t i, size_t j, value_type value)
+        {
+            return m_ptr[i * m_rs + j * m_cs] = value;
+        }
+
+        T* data() const
+        {
+            return m_ptr;
+        }
+
+        size_t row_stride() const
+        {
+            return m_rs;
+        }
+
+        size_t col_stride() const
+        {
+            return m_cs;
+        }
+
+        bool aliases(const void* lo, const void* hi) const
+        {
+            return lo < (const void*) (m_ptr + extent()) && (const void*) m_ptr < hi;
+        }
+
+    private:
+        size_t extent() const
+        {
+            return (m - 1) * m_rs + (n - 1) * m_cs + 1;
+        }
+
+        T* m_ptr;
+        size_t m_rs, m_cs;
+    };
+
+    namespace detail {
+        /**
+        * @brief Strided storage of a %transpose_view, present if the viewed %matrix has it (see has_storage).
+        */
+        template <typename M, bool = has_storage<M>::value>
+        class transposed_storage { };
+
+        template <typename M>
+        class transposed_storage<M, true> {
+        public:
+            auto data() const
+            {
+                return static_cast<const transpose_view<M>*>(this)->inner().data();
+            }
+
+            size_t row_stride() const
+            {
+                return static_cast<const transpose_view<M>*>(this)->inner().col_stride();
+            }
+
+            size_t col_stride() const
+            {
+                return static_cast<const transpose_view<M>*>(this)->inner().row_stride();
+            }
+        };
+    }
+
+    /**
+     * @brief Zero-copy transpose of a %matrix.
+     * @tparam M Type of the viewed %matrix; const-qualify it for a read-only view.
+     *
+     * Element i,j is element j,i of the viewed %matrix. If that %matrix has
+     * strided storage, the view has it too with the strides swapped, so
+     * matmul() and gemm() run it on the vectorized kernel, whose packing
+     * turns the strided operand into contiguous panels. On the loop path,
+     * a transposed left operand is multiplied by rank-1 updates so that
+     * both operands are read along their stored rows; A * B^T already
+     * reads rows of both. Create one with transpose().
+     *
+     * @warning The view keeps a reference to the viewed %matrix, which must outlive it.
+     */
+    template <typename M>
+    class transpose_view : public static_matrix<transpose_view<M>, typename M::value_type, M::cols, M::rows>,
+                           public detail::transposed_storage<M>, public adaptor {
+    public:
+        typedef typename M::value_type T;
+
+        explicit transpose_view(M& inner) : m_inner(inner) { }
+
+        T get(size_t i, size_t j) const
+        {
+            return m_inner.get(j, i);
+        }
+
+        T set(size_t i, size_t j, T value)
+        {
+            return m_inner.set(j, i, value);
+        }
+
+        bool aliases(const void* lo, const void* hi) const
+        {
+            return m_inner.aliases(lo, hi);
+        }
+
+        /**
+        * @brief Accesses the viewed %matrix.
+        */
+        M& inner() const
+        {
+            return m_inner;
+        }
+
+    private:
+        M& m_inner;
+    };
+
+    /**
+     * @brief Zero-copy symmetric %matrix defined by the upper triangle of a square %matrix.
+     * @tparam M Type of the viewed %matrix.
+     *
+     * Element i,j is element min(i,j),max(i,j) of the viewed %matrix; the
+     * strict lower triangle is never read. matmul() and gemm() multiply by
+     * a %symmetric_view as in BLAS symm: every stored element is read once,
+     * along rows, and used for both of the products it takes part in.
+     * Create one with symmetric(). The view is read-only: it has no set(), so
+     * assigning to it fails to compile.
+     *
+     * @warning The view keeps a reference to the viewed %matrix, which must outlive it.
+     */
+    template <typename M>
+    class symmetric_view : public static_matrix<symmetric_view<M>, typename M::value_type, M::rows, M::cols>, public adaptor {
+    public:
+        typedef typename M::value_type T;
+        static_assert(M::rows == M::cols, "symmetric_view requires a square matrix");
+
+        explicit symmetric_view(const M& inner) : m_inner(inner) { }
+
+        T get(size_t i, size_t j) const
+        {
+            return i <= j ? m_inner.get(i, j) : m_inner.get(j, i);
+        }
+
+        bool aliases(const void* lo, const void* hi) const
+        {
+            return m_inner.aliases(lo, hi);
+        }
+
+        /**
+        * @brief Accesses the viewed %matrix.
+        */
+        const M& inner() const
+        {
+            return m_inner;
+        }
+
+    private:
+        const M& m_inner;
+    };
+
+    /**
+    * @brief Transposes a %matrix without copying it.
+    * @return %transpose_view of mat, writable if mat is.
+    */
+    template <typename D, typename T, size_t m, size_t n>
+    transpose_view<D> transpose(static_matrix<D, T, m, n>& mat)
+    {
+        return transpose_view<D>(mat.derived());
+    }
+
+    template <typename D, typename T, size_t m, size_t n>
+    transpose_view<const D> transpose(const static_matrix<D, T, m, n>& mat)
+    {
+        return transpose_view<const D>(mat.derived());
+    }
+
+    /**
+    * @brief Views the upper triangle of a square %matrix as a symmetric %matrix.
+    * @return %symmetric_view of mat.
+    */
+    template <typename D, typename T, size_t n>
+    symmetric_view<D> symmetric(const static_matrix<D, T, n, n>& mat)
+    {
+        return symmetric_view<D>(mat.derived());
+    }
+
+    /**
+    * @brief Lazy entrywise sum (or difference) of two matrices.
+    * @tparam L,R Operand types.
+    * @tparam sign +1 for a sum, -1 for a difference.
+    */
+    template <typename L, typename R, int sign>
+    class sum_expr : public static_matrix<sum_expr<L, R, sign>, typename L::value_type, L::rows, L::cols>, public expression {
+    public:
+        typedef typename L::value_type T;
+
+        sum_expr(const L& left, const R& right) : m_left(left), m_right(right) { }
+
+        T get(size_t i, size_t j) const
+        {
+            if (sign > 0) {
+                return m_left.get(i, j) + m_right.get(i, j);
+            } else {
+                return m_left.get(i, j) - m_right.get(i, j);
+            }
+        }
+
+        bool aliases(const void* lo, const void* hi) const
+        {
+            return m_left.aliases(lo, hi) || m_right.aliases(lo, hi);
+        }
+
+    private:
+        detail::operand_t<L> m_left;
+        detail::operand_t<R> m_right;
+    };
+
+    /**
+    * @brief Lazy %matrix product.
+    * @tparam L,R Operand types.
+    *
+    * Each element is a dot product evaluated on access. Operands that are
+    * themselves expressions are evaluated once into a %basematrix held by the
+    * node (on the stack), so nested products do not recompute their inputs.
+    */
+    template <typename L, typename R>
+    class product_expr : public static_matrix<product_expr<L, R>, typename L::value_type, L::rows, R::cols>, public expression {
+    public:
+        typedef typename L::value_type T;
+
+        product_expr(const L& left, const R& right) : m_left(left), m_right(right) { }
+
+        T get(size_t i, size_t j) const
+        {
+            T acc = 0;
+            for (size_t k = 0; k < L::cols; ++k) {
+                acc += m_left.get(i, k) * m_right.get(k, j);
+            }
+            return acc;
+        }
+
+        bool aliases(const void* lo, const void* hi) const
+        {
+            return m_left.aliases(lo, hi) || m_right.aliases(lo, hi);
+        }
+
+        const auto& left() const
+        {
+            return m_left;
+        }
+
+        const auto& right() const
+        {
+            return m_right;
+        }
+
+    private:
+        template <typename X>
+        using stored_t = typename std::conditional<std::is_base_of<expression, X>::value,
+                                                   const basematrix<T, X::rows, X::cols>, detail::operand_t<X>>::type;
+
+        stored_t<L> m_left;
+        stored_t<R> m_right;
+    };
+
+    namespace detail {
+        /**
+        * @brief Copies a row segment of at most n elements.
+        *
+        * Rows of up to 64 bytes are copied by a loop the compiler unrolls,
+        * as a call to memmove costs more than the copy itself at that size.
+        */
+        template <size_t n, typename S, typename D>
+        void copy_segment(const S* src, size_t count, D* dest)
+        {
+            if constexpr (n * sizeof(D) <= 64) {
+                for (size_t c = 0; c < count; ++c) {
+                    dest[c] = src[c];
+                }
+            } else {
+                std::copy_n(src, count, dest);
+            }
+        }
+
+        /**
+        * @brief Copies an @a m*n block row by row between layouts with unit column stride.
+        *
+        * Rows that wrap on neither side are one segment of a length known at
+        * compile time; the others are split into at most three segments
+        * where either side wraps, or copied through a table of columns
+        * when rows are short.
+        */
+        template <size_t m, size_t n, typename S, typename D>
+        void copy_rows(const strided_layout<S>& src, const strided_layout<D>& dest)
+        {
+            size_t si = src.i, di = dest.i;
+            if (src.split() >= n && dest.split() >= n) {
+                for (size_t r = 0; r < m; ++r) {
+                    copy_segment<n>(src.origin + si * src.rs + src.j, n, dest.origin + di * dest.rs + dest.j);
+                    si = si + 1 == src.rows ? 0 : si + 1;
+                    di = di + 1 == dest.rows ? 0 : di + 1;
+                }
+                return;
+            }
+            if constexpr (n * sizeof(D) <= 64) {
+                // Short rows: one table of columns beats segment bookkeeping.
+                size_t from[n], to[n];
+                for (size_t c = 0; c < n; ++c) {
+                    from[c] = src.column(c);
+                    to[c] = dest.column(c);
+                }
+                for (size_t r = 0; r < m; ++r) {
+                    S* sp = src.origin + si * src.rs;
+                    D* dp = dest.origin + di * dest.rs;
+                    for (size_t c = 0; c < n; ++c) {
+                        dp[to[c]] = sp[from[c]];
+                    }
+                    si = si + 1 == src.rows ? 0 : si + 1;
+                    di = di + 1 == dest.rows ? 0 : di + 1;
+                }
+                return;
+            }
+            // Every row splits at the same columns, so the segments are found once.
+            size_t cuts[3] = {std::min(src.split(), dest.split()), std::max(src.split(), dest.split()), n};
+            size_t from[3], to[3], count[3];
+            size_t segments = 0;
+            for (size_t c = 0, k = 0; k < 3; ++k) {
+                size_t cut = std::min(cuts[k], n);
+                if (cut > c) {
+                    from[segments] = src.column(c);
+                    to[segments] = dest.column(c);
+                    count[segments++] = cut - c;
+                    c = cut;
+                }
+            }
+            for (size_t r = 0; r < m; ++r) {
+                S* sp = src.origin + si * src.rs;
+                D* dp = dest.origin + di * dest.rs;
+                for (size_t k = 0; k < segments; ++k) {
+                    copy_segment<n>(sp + from[k], count[k], dp + to[k]);
+                }
+                si = si + 1 == src.rows ? 0 : si + 1;
+                di = di + 1 == dest.rows ? 0 : di + 1;
+            }
+        }
+
+        /**
+        * @brief Storage layout of any %matrix; the origin is null where elements are not addressable.
+        */
+        template <typename X>
+        auto layout_of(X& x)
+        {
+            typedef typename X::value_type T;
+            if constexpr (has_layout<X>::value) {
+                return x.layout();
+            } else if constexpr (has_storage<X>::value) {
+                typedef typename std::remove_pointer<decltype(x.data())>::type E;
+                return strided_layout<E>{x.data(), x.row_stride(), x.col_stride(), X::rows, X::cols, 0, 0};
+            } else if constexpr (std::is_base_of<matrix<T, X::rows, X::cols>, X>::value && !std::is_const<X>::value) {
+                strided_layout<T> l{nullptr, 0, 0, X::rows, X::cols, 0, 0};
+                l.origin = x.storage(l.rs, l.cs);
+                return l;
+            } else {
+                return strided_layout<const T>{nullptr, 0, 0, X::rows, X::cols, 0, 0};
+            }
+        }
+
+        /**
+        * @brief Evaluates src into dest, which src must not read from.
+        *
+        * The body of assign() after its alias check. Constructors call it
+        * directly: an object under construction cannot be read by its source.
+        */
+        template <typename D, typename S, typename T, size_t m, size_t n>
+        void assign_unaliased(static_matrix<D, T, m, n>& dest, const static_matrix<S, T, m, n>& src)
+        {
+            D& d = dest.derived();
+            const S& s = src.derived();
+            if constexpr (is_product<S>::value) {
+                matmul(s.left(), s.right(), d);
+            } else {
+                auto dl = layout_of(d);
+                auto sl = layout_of(s);
+                if constexpr (!std::is_const<typename std::remove_pointer<decltype(dl.origin)>::type>::value) {
+                    if (dl.origin && sl.origin && dl.cs == 1 && sl.cs == 1) {
+                        copy_rows<m, n>(sl, dl);
+                        return;
+                    }
+                }
+                for (size_t i = 0; i < m; ++i) {
+                    for (size_t j = first_written<D>(i); j < n; ++j) {
+                        d.set(i, j, s.get(i, j));
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+    * @brief Evaluates a %matrix or expression into dest.
+    * @tparam T Type of elements.
+    * @tparam m,n Dimensions of both matrices.
+    * @param dest Reference to %matrix to write.
+    * @param src Reference to %matrix or expression to read.
+    *
+    * When both sides have addressable storage with unit column stride
+    * (%basematrix, %matrix_view, %dynmatrix blocks, %erased wrappers of
+    * those, and any %submatrix over them, wrapping or not), every row is
+    * copied with std::copy_n in at most three segments, split where
+    * either side reaches the right edge of its underlying array. Products
+    * run on matmul(); everything else is copied element by element. A
+    * source that reads from the storage of dest is evaluated into a
+    * temporary on the stack first.
+    */
+    template <typename D, typename S, typename T, size_t m, size_t n>
+    void assign(static_matrix<D, T, m, n>& dest, const static_matrix<S, T, m, n>& src)
+    {
+        auto dl = detail::layout_of(dest.derived());
+        if (dl.origin && src.derived().aliases(dl.origin, dl.end())) {
+            basematrix<T, m, n> tmp(src.derived());
+            detail::assign_unaliased(dest, tmp);
+            return;
+        }
+        detail::assign_unaliased(dest, src);
+    }
+
+    /**
+    * @brief Lazy entrywise sum of two matrices.
+    * @return Expression evaluated when assigned to a %basematrix.
+    */
+    template <typename L, typename R, typename T, size_t m, size_t n>
+    sum_expr<L, R, 1> operator+(const static_matrix<L, T, m, n>& left, const static_matrix<R, T, m, n>& right)
+    {
+        return sum_expr<L, R, 1>(left.derived(), right.derived());
+    }
+
+    /**
+    * @brief Lazy entrywise difference of two matrices.
+    * @return Expression evaluated when assigned to a %basematrix.
+    */
+    template <typename L, typename R, typename T, size_t m, size_t n>
+    sum_expr<L, R, -1> operator-(const static_matrix<L, T, m, n>& left, const static_matrix<R, T, m, n>& right)
+    {
+        return sum_expr<L, R, -1>(left.derived(), right.derived());
+    }
+
+    /**
+    * @brief Lazy %matrix product of an @a m*n and an @a n*o %matrix.
+    * @return Expression evaluated when assigned to a %basematrix.
+    */
+    template <typename L, typename R, typename T, size_t m, size_t n, size_t o>
+    product_expr<L, R> operator*(const static_matrix<L, T, m, n>& left, const static_matrix<R, T, n, o>& right)
+    {
+        return product_expr<L, R>(left.derived(), right.derived());
+    }
+
+    /**
+    * @brief Calculates the determinant of the %matrix.
+    * @tparam T Type of elements.
+    * @tparam n Number of rows and number of columns.
+    * @param mat %matrix to calculate determinant of.
+    * @return Determinant of type T.
+    *
+    * Orders up to 3 are expanded in closed form. Larger orders factor a copy
+    * of the %matrix on the stack in O(n^3): floating point types with the
+    * pivoted LU shared with inverse, integral types with fraction-free
+    * Bareiss elimination so the result stays exact.
+    */
+    template <typename D, typename T, size_t n>
+    T det(const static_matrix<D, T, n, n>& mat)
+    {
+        const D& a = mat.derived();
+        if constexpr (n == 1) {
+            return a.get(0, 0);
+        } else if constexpr (n == 2) {
+            return a.get(0, 0) * a.get(1, 1) - a.get(0, 1) * a.get(1, 0);
+        } else if constexpr (n == 3) {
+            return a.get(0, 0) * (a.get(1, 1) * a.get(2, 2) - a.get(1, 2) * a.get(2, 1))
+                 - a.get(0, 1) * (a.get(1, 0) * a.get(2, 2) - a.get(1, 2) * a.get(2, 0))
+                 + a.get(0, 2) * (a.get(1, 0) * a.get(2, 1) - a.get(1, 1) * a.get(2, 0));
+        } else if constexpr (std::is_integral<T>::value) {
+            basematrix<T, n, n> tmp(a);
+            return detail::bareiss_det(n, tmp.data(), n);
+        } else {
+            basematrix<T, n, n> lu(a);
+            size_t piv[n];
+            if (detail::lu_factor(n, lu.data(), n, piv)) {
+                return T(0);
+            }
+            T acc = 1;
+            for (size_t k = 0; k < n; ++k) {
+                acc *= piv[k] == k ? lu.get(k, k) : -lu.get(k, k);
+            }
+            return acc;
+        }
+    }
+
+    /**
+    * @brief Calculates the logarithm of the absolute determinant of the %matrix.
+    * @tparam T Floating point type of elements.
+    * @tparam n Number of rows and number of columns.
+    * @param mat %matrix to calculate the log-determinant of.
+    * @param sign Set to the sign of the determinant: -1, 1, or 0 if the %matrix is singular.
+    * @return log|det(mat)|, or -infinity if the %matrix is singular.
+    *
+    * Sums the logarithms of the LU pivots, so the result stays finite where
+    * det itself would underflow or overflow.
+    */
+    template <typename D, typename T, size_t n>
+    T logdet(const static_matrix<D, T, n, n>& mat, int& sign)
+    {
+        static_assert(std::is_floating_point<T>::value, "logdet requires a floating point element type");
+        basematrix<T, n, n> lu(mat.derived());
+        size_t piv[n];
+        if (detail::lu_factor(n, lu.data(), n, piv)) {
+            sign = 0;
+            return -std::numeric_limits<T>::infinity();
+        }
+        T acc = 0;
+        sign = 1;
+        for (size_t k = 0; k < n; ++k) {
+            T u = lu.get(k, k);
+            if ((u < T(0)) != (piv[k] != k)) {
+                sign = -sign;
+            }
+            acc += std::log(std::abs(u));
+        }
+        return acc;
+    }
+
+    /**
+    * @brief Calculates the determinant of a type-erased %matrix.
     * @tparam T Type of elements.
     * @tparam n Number of rows and number of columns.
+    * @param mat Shared pointer to %matrix to calculate determinant of.
+    * @return Determinant of type T.
+    */
+    template <typename T, size_t n>
+    T det(std::shared_ptr<matrix<T, n, n>> mat)
+    {
+        return det(*mat);
+    }
+
+    /**
+    * @brief Calculates the %inverse of a square %matrix and writes it into dest.
+    * @tparam T Floating point type of elements.
+    * @tparam n Number of rows and number of columns.
     * @param src Reference to %matrix to invert.
     * @param dest Reference to %matrix to write results.
     * @return true if src is singular (ie non-invertible).
@@ -331,11 +1361,284 @@ namespace gmat {
     *
     * This function writes the inverse of src into dest, unless src is singular,
     * in which case it return true and leaves dest unchanged.
+    *
+    * Orders 1 to 4 use the closed-form adjugate, fully unrolled; larger
+    * orders factor a copy of src with partial pivoting (detail::lu_factor).
+    * src and dest may be the same %matrix.
     */
-    template <typename T, size_t n>
-    bool inverse(matrix<T, n, n> &src, matrix<T, n, n> &dest)
+    template <typename S, typename D, typename T, size_t n>
+    bool inverse(const static_matrix<S, T, n, n>& src, static_matrix<D, T, n, n>& dest)
     {
-        return false;
+        static_assert(std::is_floating_point<T>::value, "inverse requires a floating point element type");
+        const S& a = src.derived();
+        D& c = dest.derived();
+        if constexpr (n == 1) {
+            T a00 = a.get(0, 0);
+            if (a00 == T(0)) {
+                return true;
+            }
+            c.set(0, 0, T(1) / a00);
+            return false;
+        } else if constexpr (n == 2) {
+            T a00 = a.get(0, 0), a01 = a.get(0, 1);
+            T a10 = a.get(1, 0), a11 = a.get(1, 1);
+            T d = a00 * a11 - a01 * a10;
+            if (d == T(0)) {
+                return true;
+            }
+            T r = T(1) / d;
+            c.set(0, 0, a11 * r);
+            c.set(0, 1, -a01 * r);
+            c.set(1, 0, -a10 * r);
+            c.set(1, 1, a00 * r);
+            return false;
+        } else if constexpr (n == 3) {
+            T a00 = a.get(0, 0), a01 = a.get(0, 1), a02 = a.get(0, 2);
+            T a10 = a.get(1, 0), a11 = a.get(1, 1), a12 = a.get(1, 2);
+            T a20 = a.get(2, 0), a21 = a.get(2, 1), a22 = a.get(2, 2);
+            T c00 = a11 * a22 - a12 * a21;
+            T c01 = a12 * a20 - a10 * a22;
+            T c02 = a10 * a21 - a11 * a20;
+            T d = a00 * c00 + a01 * c01 + a02 * c02;
+            if (d == T(0)) {
+                return true;
+            }
+            T r = T(1) / d;
+            c.set(0, 0, c00 * r);
+            c.set(0, 1, (a02 * a21 - a01 * a22) * r);
+            c.set(0, 2, (a01 * a12 - a02 * a11) * r);
+            c.set(1, 0, c01 * r);
+            c.set(1, 1, (a00 * a22 - a02 * a20) * r);
+            c.set(1, 2, (a02 * a10 - a00 * a12) * r);
+            c.set(2, 0, c02 * r);
+            c.set(2, 1, (a01 * a20 - a00 * a21) * r);
+            c.set(2, 2, (a00 * a11 - a01 * a10) * r);
+            return false;
+        } else if constexpr (n == 4) {
+            T a00 = a.get(0, 0), a01 = a.get(0, 1), a02 = a.get(0, 2), a03 = a.get(0, 3);
+            T a10 = a.get(1, 0), a11 = a.get(1, 1), a12 = a.get(1, 2), a13 = a.get(1, 3);
+            T a20 = a.get(2, 0), a21 = a.get(2, 1), a22 = a.get(2, 2), a23 = a.get(2, 3);
+            T a30 = a.get(3, 0), a31 = a.get(3, 1), a32 = a.get(3, 2), a33 = a.get(3, 3);
+            // 2x2 minors of the top two rows (s) and of the bottom two rows (t).
+            T s0 = a00 * a11 - a10 * a01;
+            T s1 = a00 * a12 - a10 * a02;
+            T s2 = a00 * a13 - a10 * a03;
+            T s3 = a01 * a12 - a11 * a02;
+            T s4 = a01 * a13 - a11 * a03;
+            T s5 = a02 * a13 - a12 * a03;
+            T t5 = a22 * a33 - a32 * a23;
+            T t4 = a21 * a33 - a31 * a23;
+            T t3 = a21 * a32 - a31 * a22;
+            T t2 = a20 * a33 - a30 * a23;
+            T t1 = a20 * a32 - a30 * a22;
+            T t0 = a20 * a31 - a30 * a21;
+            T d = s0 * t5 - s1 * t4 + s2 * t3 + s3 * t2 - s4 * t1 + s5 * t0;
+            if (d == T(0)) {
+                return true;
+            }
+            T r = T(1) / d;
+            c.set(0, 0, ( a11 * t5 - a12 * t4 + a13 * t3) * r);
+            c.set(0, 1, (-a01 * t5 + a02 * t4 - a03 * t3) * r);
+            c.set(0, 2, ( a31 * s5 - a32 * s4 + a33 * s3) * r);
+            c.set(0, 3, (-a21 * s5 + a22 * s4 - a23 * s3) * r);
+            c.set(1, 0, (-a10 * t5 + a12 * t2 - a13 * t1) * r);
+            c.set(1, 1, ( a00 * t5 - a02 * t2 + a03 * t1) * r);
+            c.set(1, 2, (-a30 * s5 + a32 * s2 - a33 * s1) * r);
+            c.set(1, 3, ( a20 * s5 - a22 * s2 + a23 * s1) * r);
+            c.set(2, 0, ( a10 * t4 - a11 * t2 + a13 * t0) * r);
+            c.set(2, 1, (-a00 * t4 + a01 * t2 - a03 * t0) * r);
+            c.set(2, 2, ( a30 * s4 - a31 * s2 + a33 * s0) * r);
+            c.set(2, 3, (-a20 * s4 + a21 * s2 - a23 * s0) * r);
+            c.set(3, 0, (-a10 * t3 + a11 * t1 - a12 * t0) * r);
+            c.set(3, 1, ( a00 * t3 - a01 * t1 + a02 * t0) * r);
+            c.set(3, 2, (-a30 * s3 + a31 * s1 - a32 * s0) * r);
+            c.set(3, 3, ( a20 * s3 - a21 * s1 + a22 * s0) * r);
+            return false;
+        } else {
+            basematrix<T, n, n> lu(a);
+            size_t piv[n];
+            if (detail::lu_factor(n, lu.data(), n, piv)) {
+                return true;
+            }
+            basematrix<T, n, n> inv(T(0));
+            for (size_t i = 0; i < n; ++i) {
+                inv.set(i, i, T(1));
+            }
+            detail::lu_solve(n, lu.data(), n, piv, inv.data(), n, n);
+            assign(c, inv);
+            return false;
+        }
+    }
+
+    /**
+    * @brief Factors a symmetric positive definite %matrix in place, A = L L^T.
+    * @tparam T Type of elements.
+    * @tparam n Number of rows and number of columns.
+    * @param mat %matrix with strided storage to factor. Only its lower triangle
+    *            is read, and it is overwritten with L; the strict upper
+    *            triangle is left untouched.
+    * @return true if mat is not positive definite, in which case its
+    *         contents are unspecified.
+    *         false if the factorization succeeded.
+    *
+    * Orders up to detail::unroll_limit are fully unrolled at compile time.
+    */
+    template <typename D, typename T, size_t n>
+    bool cholesky(static_matrix<D, T, n, n>& mat)
+    {
+        static_assert(detail::has_storage<D>::value, "cholesky works in place on matrices with strided storage");
+        D& a = mat.derived();
+        if constexpr (n <= detail::unroll_limit) {
+            return detail::cholesky_factor<n>(a.data(), a.row_stride(), a.col_stride());
+        } else {
+            return detail::cholesky_factor(n, a.data(), a.row_stride(), a.col_stride());
+        }
+    }
+
+    /**
+    * @brief Solves A X = B in place, given the Cholesky factor of A.
+    * @tparam T Type of elements.
+    * @tparam n Order of A.
+    * @tparam k Number of right-hand sides.
+    * @param chol Factor L written by cholesky.
+    * @param rhs @a n*k right-hand sides, overwritten with the solution X.
+    *
+    * @invariant chol is unchanged.
+    */
+    template <typename C, typename B, typename T, size_t n, size_t k>
+    void cholesky_solve(const static_matrix<C, T, n, n>& chol, static_matrix<B, T, n, k>& rhs)
+    {
+        static_assert(detail::has_storage<C>::value && detail::has_storage<B>::value,
+                      "cholesky_solve works in place on matrices with strided storage");
+        const C& l = chol.derived();
+        B& b = rhs.derived();
+        if constexpr (n <= detail::unroll_limit) {
+            detail::cholesky_solve<n>(l.data(), l.row_stride(), l.col_stride(), b.data(), b.row_stride(), b.col_stride(), k);
+        } else {
+            detail::cholesky_solve(n, l.data(), l.row_stride(), l.col_stride(), b.data(), b.row_stride(), b.col_stride(), k);
+        }
+    }
+
+    /**
+    * @brief Calculates the %inverse of a symmetric positive definite %matrix from its Cholesky factor.
+    * @tparam T Type of elements.
+    * @tparam n Order of the %matrix.
+    * @param chol Factor L written by cholesky.
+    * @param dest Reference to %matrix to write results.
+    *
+    * @invariant chol is unchanged.
+    */
+    template <typename C, typename D, typename T, size_t n>
+    void cholesky_inverse(const static_matrix<C, T, n, n>& chol, static_matrix<D, T, n, n>& dest)
+    {
+        basematrix<T, n, n> inv(T(0));
+        for (size_t i = 0; i < n; ++i) {
+            inv.set(i, i, T(1));
+        }
+        cholesky_solve(chol, inv);
+        assign(dest, inv);
+    }
+
+    namespace detail {
+        /**
+        * @brief Checks whether src may read the storage of dest.
+        *
+        * Destinations without addressable storage are not checked, as in
+        * assign().
+        */
+        template <typename D, typename S>
+        bool overlaps(D& dest, const S& src)
+        {
+            auto l = layout_of(dest);
+            return l.origin && src.aliases(l.origin, l.end());
+        }
+
+        /**
+        * @brief Scales C by beta before products are accumulated into it; C is not read if beta is zero.
+        */
+        template <typename D, typename T>
+        void scale_for_update(T beta, D& c)
+        {
+            for (size_t i = 0; i < D::rows; ++i) {
+                for (size_t j = 0; j < D::cols; ++j) {
+                    c.set(i, j, beta == T(0) ? T(0) : beta * c.get(i, j));
+                }
+            }
+        }
+
+        /**
+        * @brief Loop path of matmul() and gemm(): C = alpha * A * B + beta * C, with no temporary.
+        *
+        * Each element is a dot product along a row of A and a column of B,
+        * which for A * B^T are rows of both. The other orders accumulate
+        * into C, so they are taken only if C overlaps neither operand:
+        * A^T * B as rank-1 updates, row k of A^T B adding A(k,i) times
+        * row k of B to row i; a %symmetric_view on either side reads its
+        * upper triangle row by row and applies each off-diagonal element
+        * to both products it belongs to.
+        */
+        template <typename L, typename R, typename D, typename T>
+        void product_loop(T alpha, const L& a, const R& b, T beta, D& c)
+        {
+            constexpr size_t m = L::rows, n = L::cols, o = R::cols;
+            constexpr bool reorder = is_symmetric<L>::value || is_symmetric<R>::value
+                                     || (is_transpose<L>::value && !is_transpose<R>::value);
+            if constexpr (reorder) {
+                if (!overlaps(c, a) && !overlaps(c, b)) {
+                    scale_for_update(beta, c);
+                    if constexpr (is_symmetric<L>::value) {
+                        const auto& s = a.inner();
+                        for (size_t i = 0; i < n; ++i) {
+                            for (size_t k = i; k < n; ++k) {
+                                T sik = alpha * s.get(i, k);
+                                for (size_t j = 0; j < o; ++j) {
+                                    c.set(i, j, c.get(i, j) + sik * b.get(k, j));
+                                }
+                                if (k != i) {
+                                    for (size_t j = 0; j < o; ++j) {
+                                        c.set(k, j, c.get(k, j) + sik * b.get(i, j));
+                                    }
+                                }
+                            }
+                        }
+                    } else if constexpr (is_symmetric<R>::value) {
+                        const auto& s = b.inner();
+                        for (size_t i = 0; i < m; ++i) {
+                            for (size_t k = 0; k < n; ++k) {
+                                T aik = alpha * a.get(i, k);
+                                T acc = c.get(i, k) + aik * s.get(k, k);
+                                for (size_t j = k + 1; j < n; ++j) {
+                                    T skj = s.get(k, j);
+                                    c.set(i, j, c.get(i, j) + aik * skj);
+                                    acc += alpha * a.get(i, j) * skj;
+                                }
+                                c.set(i, k, acc);
+                            }
+                        }
+                    } else {
+                        const auto& at = a.inner();
+                        for (size_t k = 0; k < n; ++k) {
+                            for (size_t i = 0; i < m; ++i) {
+                                T aki = alpha * at.get(k, i);
+                                for (size_t j = 0; j < o; ++j) {
+                                    c.set(i, j, c.get(i, j) + aki * b.get(k, j));
+                                }
+                            }
+                        }
+                    }
+                    return;
+                }
+            }
+            for (size_t i = 0; i < m; ++i) {
+                for (size_t j = 0; j < o; ++j) {
+                    T acc = 0;
+                    for (size_t k = 0; k < n; ++k) {
+                        acc += a.get(i, k) * b.get(k, j);
+                    }
+                    c.set(i, j, beta == T(0) ? alpha * acc : alpha * acc + beta * c.get(i, j));
+                }
+            }
+        }
     }
 
     /**
@@ -348,19 +1651,36 @@ namespace gmat {
      * @param dest Reference to %matrix to write results
      *
      * @invariant left, right are unchanged.
+     *
+     * For float and double operands with strided storage (see
+     * detail::has_storage) that are large enough to fill the register tile,
+     * the product runs on the vectorized detail::gemm kernel. Other
+     * products run on detail::product_loop, whose loop order depends on
+     * whether an operand is a %transpose_view or a %symmetric_view.
      */
-    template <typename T, size_t m, size_t n, size_t o>
-    void matmul(matrix<T, m, n>& left, matrix<T, n, o>& right, matrix<T, m, o>& dest)
+    template <typename L, typename R, typename D, typename T, size_t m, size_t n, size_t o>
+    void matmul(const static_matrix<L, T, m, n>& left, const static_matrix<R, T, n, o>& right, static_matrix<D, T, m, o>& dest)
     {
-        for (int i = 0; i < m; ++i) {
-            for (int j = 0; j < o; ++j) {
-                T a = 0;
-                for (int k = 0; k < n; ++k) {
-                    a += left.get(i, k) * right.get(k, j);
-                }
-                dest.set(i, j, a);
+        const L& a = left.derived();
+        const R& b = right.derived();
+        D& c = dest.derived();
+        if constexpr (detail::stores_upper<D>::value) {
+            // The product loops accumulate into every element.
+            basematrix<T, m, o> tmp;
+            matmul(a, b, tmp);
+            detail::assign_unaliased(dest, tmp);
+            return;
+        }
+        if constexpr ((std::is_same<T, float>::value || std::is_same<T, double>::value)
+                      && detail::has_storage<L>::value && detail::has_storage<R>::value && detail::has_storage<D>::value
+                      && m >= detail::gemm_blocking<T>::mr && o >= detail::gemm_blocking<T>::nr) {
+            if (c.col_stride() == 1) {
+                detail::gemm<T>(m, n, o, T(1), a.data(), a.row_stride(), a.col_stride(),
+                                b.data(), b.row_stride(), b.col_stride(), T(0), c.data(), c.row_stride());
+                return;
             }
         }
+        detail::product_loop(T(1), a, b, T(0), c);
     }
 
     /**
@@ -373,14 +1693,145 @@ namespace gmat {
      *
      * @invariant left, right are unchanged.
      */
-    template <typename T, size_t m, size_t n>
-    void matadd(matrix<T, m, n>& left, matrix<T, m, n>& right, matrix<T, m, n>& dest)
+    template <typename L, typename R, typename D, typename T, size_t m, size_t n>
+    void matadd(const static_matrix<L, T, m, n>& left, const static_matrix<R, T, m, n>& right, static_matrix<D, T, m, n>& dest)
+    {
+        const L& a = left.derived();
+        const R& b = right.derived();
+        D& c = dest.derived();
+        for (size_t i = 0; i < m; ++i) {
+            for (size_t j = detail::first_written<D>(i); j < n; ++j) {
+                c.set(i, j, a.get(i, j) + b.get(i, j));
+            }
+        }
+    }
+
+    /**
+     * @brief Calculates C = alpha * A * B + beta * C in place.
+     * @tparam T Type of elements.
+     * @tparam m,n,o A is @a m*n, B is @a n*o and C is @a m*o.
+     * @param alpha Scale of the product.
+     * @param left Reference to left %matrix to multiply.
+     * @param right Reference to right %matrix to multiply.
+     * @param beta Scale of the previous contents of dest. If zero, dest is not read.
+     * @param dest Reference to %matrix to update.
+     *
+     * @invariant left, right are unchanged.
+     *
+     * Takes the vectorized detail::gemm kernel under the same conditions as
+     * matmul(), with beta folded into the store of each tile. If left or
+     * right reads from dest, the product is first evaluated into a
+     * temporary on the stack.
+     */
+    template <typename L, typename R, typename D, typename T, size_t m, size_t n, size_t o>
+    void gemm(typename static_matrix<D, T, m, o>::value_type alpha, const static_matrix<L, T, m, n>& left,
+              const static_matrix<R, T, n, o>& right, typename static_matrix<D, T, m, o>::value_type beta,
+              static_matrix<D, T, m, o>& dest)
+    {
+        const L& a = left.derived();
+        const R& b = right.derived();
+        D& c = dest.derived();
+        if (detail::stores_upper<D>::value || detail::overlaps(c, a) || detail::overlaps(c, b)) {
+            basematrix<T, m, o> tmp;
+            matmul(a, b, tmp);
+            for (size_t i = 0; i < m; ++i) {
+                for (size_t j = detail::first_written<D>(i); j < o; ++j) {
+                    c.set(i, j, beta == T(0) ? alpha * tmp.get(i, j) : alpha * tmp.get(i, j) + beta * c.get(i, j));
+                }
+            }
+            return;
+        }
+        if constexpr ((std::is_same<T, float>::value || std::is_same<T, double>::value)
+                      && detail::has_storage<L>::value && detail::has_storage<R>::value && detail::has_storage<D>::value
+                      && m >= detail::gemm_blocking<T>::mr && o >= detail::gemm_blocking<T>::nr) {
+            if (c.col_stride() == 1) {
+                detail::gemm<T>(m, n, o, alpha, a.data(), a.row_stride(), a.col_stride(),
+                                b.data(), b.row_stride(), b.col_stride(), beta, c.data(), c.row_stride());
+                return;
+            }
+        }
+        detail::product_loop(alpha, a, b, beta, c);
+    }
+
+    /**
+     * @brief Calculates Y = alpha * X + Y in place.
+     * @tparam T Type of elements.
+     * @tparam m,n Dimensions of both matrices.
+     * @param alpha Scale of x.
+     * @param x Reference to %matrix or expression to add.
+     * @param y Reference to %matrix to update.
+     *
+     * @invariant x is unchanged.
+     *
+     * A product expression runs on gemm() with beta = 1, so y += A * B
+     * needs no temporary. Anything else is added entrywise, through a
+     * temporary on the stack only if x reads from y other than at the
+     * element being written.
+     */
+    template <typename X, typename Y, typename T, size_t m, size_t n>
+    void axpy(typename static_matrix<Y, T, m, n>::value_type alpha, const static_matrix<X, T, m, n>& x,
+              static_matrix<Y, T, m, n>& y)
+    {
+        const X& a = x.derived();
+        Y& c = y.derived();
+        if constexpr (detail::is_product<X>::value) {
+            gemm(alpha, a.left(), a.right(), T(1), c);
+        } else {
+            // y itself reads each element just before it is written.
+            bool same = false;
+            if constexpr (std::is_same<X, Y>::value) {
+                same = &a == &c;
+            }
+            if (!same && detail::overlaps(c, a)) {
+                basematrix<T, m, n> tmp(a);
+                axpy(alpha, tmp, y);
+                return;
+            }
+            for (size_t i = 0; i < m; ++i) {
+                for (size_t j = detail::first_written<Y>(i); j < n; ++j) {
+                    c.set(i, j, alpha * a.get(i, j) + c.get(i, j));
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Adds a %matrix or expression to dest in place. See axpy().
+     * @return Reference to dest.
+     */
+    template <typename D, typename S, typename T, size_t m, size_t n>
+    D& operator+=(static_matrix<D, T, m, n>& dest, const static_matrix<S, T, m, n>& src)
+    {
+        axpy(T(1), src, dest);
+        return dest.derived();
+    }
+
+    /**
+     * @brief Subtracts a %matrix or expression from dest in place. See axpy().
+     * @return Reference to dest.
+     */
+    template <typename D, typename S, typename T, size_t m, size_t n>
+    D& operator-=(static_matrix<D, T, m, n>& dest, const static_matrix<S, T, m, n>& src)
+    {
+        axpy(T(-1), src, dest);
+        return dest.derived();
+    }
+
+    /**
+     * @brief Scales every element of dest in place.
+     * @param alpha Scale factor.
+     * @return Reference to dest.
+     */
+    template <typename D, typename T, size_t m, size_t n>
+    D& operator*=(static_matrix<D, T, m, n>& dest, typename static_matrix<D, T, m, n>::value_type alpha)
     {
-        for (int i = 0; i < m; ++i) {
-            for (int j = 0; j < n; ++j) {
-                dest.set(i, j, left.get(i, j) + right.get(i, j));
+        D& c = dest.derived();
+        for (size_t i = 0; i < m; ++i) {
+            for (size_t j = detail::first_written<D>(i); j < n; ++j) {
+                c.set(i, j, alpha * c.get(i, j));
             }
         }
+        return c;
     }
 }
 
@@ -0,0 +1,347 @@
+#ifndef __PARALLEL_HH__
+#define __PARALLEL_HH__
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace gabp {
+    namespace detail {
+        /**
+        * @brief Size of a cache line, used to keep per-thread data apart.
+        */
+        constexpr size_t cache_line = 64;
+
+        /**
+        * @brief Reusable barrier for a fixed number of threads.
+        *
+        * The last thread to arrive opens the next generation; the others spin
+        * on it, yielding after a short while so that oversubscribed machines
+        * still make progress. Arriving is a release and leaving an acquire, so
+        * everything written before wait() is visible to every thread after it.
+        */
+        class barrier {
+        public:
+            explicit barrier(size_t count) : m_count(count), m_waiting(0), m_generation(0) { }
+
+            barrier(const barrier&) = delete;
+            barrier& operator=(const barrier&) = delete;
+
+            void wait()
+            {
+                size_t gen = m_generation.load(std::memory_order_acquire);
+                if (m_waiting.fetch_add(1, std::memory_order_acq_rel) + 1 == m_count) {
+                    m_waiting.store(0, std::memory_order_relaxed);
+                    m_generation.fetch_add(1, std::memory_order_release);
+                    return;
+                }
+                for (size_t spins = 0; m_generation.load(std::memory_order_acquire) == gen; ++spins) {
+                    if (spins >= 64) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+
+        private:
+            const size_t m_count;
+            alignas(cache_line) std::atomic<size_t> m_waiting;
+            alignas(cache_line) std::atomic<size_t> m_generation;
+        };
+
+        /**
+        * @brief Splits rows into contiguous ranges of about equal work.
+        * @param off Row offsets of a compressed %matrix, n + 1 entries.
+        * @param n Number of rows.
+        * @param parts Number of ranges.
+        * @return parts + 1 boundaries; range t is rows [ret[t], ret[t + 1]).
+        *
+        * The work of a row is its number of entries plus one, so that empty
+        * rows are not free. Contiguous ranges keep each thread on its own
+        * slice of the message arrays.
+        */
+        inline std::vector<size_t> partition(const size_t* off, size_t n, size_t parts)
+        {
+            std::vector<size_t> bounds(parts + 1, n);
+            size_t total = off[n] + n;
+            size_t row = 0;
+            for (size_t t = 0; t < parts; ++t) {
+                bounds[t] = row;
+                size_t target = total * (t + 1) / parts;
+                while (row < n && off[row + 1] + row + 1 <= target) {
+                    ++row;
+                }
+            }
+            bounds[parts] = n;
+            return bounds;
+        }
+
+        /**
+        * @brief Resolves a requested thread count, where 0 means one per hardware thread.
+        */
+        inline size_t thread_count(size_t requested)
+        {
+            if (requested == 0) {
+                requested = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+            }
+            return requested;
+        }
+
+        /**
+        * @brief Fixed-size array of atomics accessed with relaxed ordering.
+        *
+        * Holds messages that threads read and overwrite concurrently. Each
+        * element is individually atomic, which is all asynchronous message
+        * passing needs; on common targets the accesses are plain moves.
+        */
+        template <typename T>
+        class relaxed_array {
+        public:
+            relaxed_array() = default;
+
+            explicit relaxed_array(size_t size) : m_data(new std::atomic<T>[size]), m_size(size) { }
+
+            T operator[](size_t k) const
+            {
+                return m_data[k].load(std::memory_order_relaxed);
+            }
+
+            void store(size_t k, T value)
+            {
+                m_data[k].store(value, std::memory_order_relaxed);
+            }
+
+            size_t size() const
+            {
+                return m_size;
+            }
+
+        private:
+            std::unique_ptr<std::atomic<T>[]> m_data;
+            size_t m_size = 0;
+        };
+
+        /**
+        * @brief Bounded work-stealing queue of item numbers.
+        *
+        * A Chase-Lev deque restricted to push and steal: only the owner
+        * pushes, and the owner and thieves all take the oldest item from the
+        * top with one compare-and-swap. The capacity is fixed, which suffices when every
+        * item is in at most one queue at a time.
+        */
+        class steal_queue {
+        public:
+            /**
+            * @brief Returned by take() when no item was taken.
+            */
+            static constexpr size_t none = size_t(-1);
+
+            explicit steal_queue(size_t capacity) : m_top(0), m_bottom(0)
+            {
+                size_t size = 1;
+                while (size < capacity) {
+                    size *= 2;
+                }
+                m_mask = size - 1;
+                m_items.reset(new std::atomic<size_t>[size]);
+            }
+
+            /**
+            * @brief Adds an item at the bottom. Owner only.
+            */
+            void push(size_t item)
+            {
+                std::int64_t b = m_bottom.load(std::memory_order_relaxed);
+                m_items[size_t(b) & m_mask].store(item, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+            }
+
+            /**
+            * @brief Takes the oldest item. Any thread.
+            * @return The item, or none if the queue is empty or another thread won the race.
+            */
+            size_t take()
+            {
+                std::int64_t t = m_top.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                std::int64_t b = m_bottom.load(std::memory_order_acquire);
+                if (t >= b) {
+                    return none;
+                }
+                size_t item = m_items[size_t(t) & m_mask].load(std::memory_order_relaxed);
+                if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    return none;
+                }
+                return item;
+            }
+
+        private:
+            alignas(cache_line) std::atomic<std::int64_t> m_top;
+            alignas(cache_line) std::atomic<std::int64_t> m_bottom;
+            std::unique_ptr<std::atomic<size_t>[]> m_items;
+            size_t m_mask;
+        };
+
+        /**
+        * @brief Distributes updates of a fixed set of items over threads by work stealing.
+        *
+        * Every worker owns a %steal_queue that receives the items it
+        * schedules, so work stays on the part of the graph the worker already
+        * touched; an idle worker steals from a randomly chosen victim. Items
+        * run oldest first: newest first would chase updates depth-first,
+        * which makes loopy message passing converge far more slowly. An item
+        * is never queued twice nor run by two workers at once: scheduling an
+        * item while it runs marks it to run again once it finishes.
+        */
+        class work_stealing {
+        public:
+            /**
+            * @param threads Number of workers, including the calling thread.
+            * @param items Number of distinct items.
+            */
+            work_stealing(size_t threads, size_t items)
+                : m_state(new std::atomic<unsigned char>[items]), m_pending(0), m_stopped(false)
+            {
+                for (size_t k = 0; k < items; ++k) {
+                    m_state[k].store(idle, std::memory_order_relaxed);
+                }
+                m_queues.reserve(threads);
+                for (size_t t = 0; t < threads; ++t) {
+                    m_queues.emplace_back(new steal_queue(items));
+                }
+            }
+
+            size_t threads() const
+            {
+                return m_queues.size();
+            }
+
+            /**
+            * @brief Queues an item on a worker's queue, unless it is already pending.
+            * @param worker Worker calling this, or any worker before run().
+            * @param item Item to run.
+            */
+            void schedule(size_t worker, size_t item)
+            {
+                // Pairs with the fence in run(): either the running task sees
+                // the caller's writes, or this sees it running and reruns it.
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                unsigned char s = m_state[item].load(std::memory_order_relaxed);
+                for (;;) {
+                    if (s == queued || s == rerun) {
+                        return;
+                    }
+                    unsigned char next = s == idle ? queued : rerun;
+                    if (m_state[item].compare_exchange_weak(s, next, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                        break;
+                    }
+                }
+                if (s == idle) {
+                    m_pending.fetch_add(1, std::memory_order_relaxed);
+                    m_queues[worker]->push(item);
+                }
+            }
+
+            /**
+            * @brief Makes every worker return from run() as soon as its current item is done.
+            */
+            void stop()
+            {
+                m_stopped.store(true, std::memory_order_relaxed);
+            }
+
+            /**
+            * @return true if stop() was called.
+            */
+            bool stopped() const
+            {
+                return m_stopped.load(std::memory_order_relaxed);
+            }
+
+            /**
+            * @brief Runs queued items until none is pending or stop() is called.
+            * @param task Called as task(worker, item); may schedule() more items.
+            *
+            * Spawns threads() - 1 threads and uses the calling one as worker 0.
+            */
+            template <typename F>
+            void run(F&& task)
+            {
+                auto work = [&](size_t w) {
+                    std::minstd_rand rng(unsigned(w) * 7919u + 1u);
+                    steal_queue& own = *m_queues[w];
+                    size_t idle_rounds = 0;
+                    size_t taken = 0;
+                    while (!stopped()) {
+                        size_t item = steal_queue::none;
+                        bool steal_first = threads() > 1 && ++taken % steal_interval == 0;
+                        if (!steal_first) {
+                            item = own.take();
+                        }
+                        if (item == steal_queue::none && threads() > 1) {
+                            size_t victim = rng() % (threads() - 1);
+                            item = m_queues[victim >= w ? victim + 1 : victim]->take();
+                        }
+                        if (item == steal_queue::none && steal_first) {
+                            item = own.take();
+                        }
+                        if (item == steal_queue::none) {
+                            if (m_pending.load(std::memory_order_acquire) == 0) {
+                                return;
+                            }
+                            if (++idle_rounds >= 64) {
+                                std::this_thread::yield();
+                            }
+                            continue;
+                        }
+                        idle_rounds = 0;
+                        m_state[item].store(running, std::memory_order_relaxed);
+                        std::atomic_thread_fence(std::memory_order_seq_cst);
+                        task(w, item);
+                        unsigned char s = running;
+                        if (m_state[item].compare_exchange_strong(s, idle, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                            m_pending.fetch_sub(1, std::memory_order_acq_rel);
+                        } else {
+                            // Scheduled while running: it stays pending and runs again here.
+                            m_state[item].store(queued, std::memory_order_relaxed);
+                            own.push(item);
+                        }
+                    }
+                };
+
+                std::vector<std::thread> workers;
+                workers.reserve(threads() - 1);
+                for (size_t t = 1; t < threads(); ++t) {
+                    workers.emplace_back(work, t);
+                }
+                work(0);
+                for (std::thread& w : workers) {
+                    w.join();
+                }
+            }
+
+        private:
+            enum : unsigned char { idle, queued, running, rerun };
+
+            /**
+            * @brief A busy worker still steals once every this many items.
+            *
+            * Otherwise the queue of a worker that is descheduled or slow
+            * starves while busy workers keep feeding their own queues.
+            */
+            static constexpr size_t steal_interval = 16;
+
+            std::vector<std::unique_ptr<steal_queue>> m_queues;
+            std::unique_ptr<std::atomic<unsigned char>[]> m_state;
+            alignas(cache_line) std::atomic<size_t> m_pending;
+            std::atomic<bool> m_stopped;
+        };
+    }
+}
+
+#endif // __PARALLEL_HH__
@@ -0,0 +1,388 @@
+#ifndef __PCG_HH__
+#define __PCG_HH__
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "gabp/dynmatrix.hh"
+#include "gabp/solver.hh"
+#include "gabp/sparse.hh"
+
+namespace gabp {
+    /**
+    * @brief Leaves the residual as it is, for plain conjugate gradients.
+    */
+    template <typename T>
+    class identity_preconditioner {
+    public:
+        void apply(const gmat::dynmatrix<T>& r, gmat::dynmatrix<T>& z) const
+        {
+            std::copy_n(r.data(), r.size(), z.data());
+        }
+    };
+
+    /**
+    * @brief Divides by the diagonal of A.
+    */
+    template <typename T>
+    class jacobi_preconditioner {
+    public:
+        /**
+        * @pre Every diagonal entry of mat is stored and positive.
+        */
+        explicit jacobi_preconditioner(const gmat::sparse_matrix<T>& mat) : m_inverse(mat.rows())
+        {
+            for (size_t i = 0; i < mat.rows(); ++i) {
+                m_inverse[i] = T(1) / mat.get(i, i);
+            }
+        }
+
+        void apply(const gmat::dynmatrix<T>& r, gmat::dynmatrix<T>& z) const
+        {
+            for (size_t i = 0; i < m_inverse.size(); ++i) {
+                z[i] = r[i] * m_inverse[i];
+            }
+        }
+
+    private:
+        std::vector<T> m_inverse;
+    };
+
+    /**
+    * @brief Solves with the diagonal blocks of A over consecutive ranges of rows.
+    *
+    * Each block is factored once by dense Cholesky. Works best when the
+    * rows are ordered so that strongly coupled variables are adjacent,
+    * as after gmat::partition_order().
+    *
+    * A block that is not positive definite, which A then is not either,
+    * falls back to its diagonal, like %jacobi_preconditioner; entries that
+    * are not positive are replaced by 1. fallbacks() counts such blocks.
+    */
+    template <typename T>
+    class block_jacobi_preconditioner {
+    public:
+        /**
+        * @param mat Symmetric positive definite sparse %matrix A.
+        * @param block Number of rows per block; the last block takes the remainder.
+        */
+        block_jacobi_preconditioner(const gmat::sparse_matrix<T>& mat, size_t block) : m_fallbacks(0)
+        {
+            assert(block > 0);
+            size_t n = mat.rows();
+            for (size_t first = 0; first < n; first += block) {
+                size_t size = std::min(block, n - first);
+                gmat::dynmatrix<T> d(size, size, T(0));
+                for (size_t i = 0; i < size; ++i) {
+                    for (auto e : mat.neighbors(first + i)) {
+                        if (e.index >= first && e.index < first + size) {
+                            d.set(i, e.index - first, e.value);
+                        }
+                    }
+                }
+                std::vector<T> diag(size);
+                for (size_t i = 0; i < size; ++i) {
+                    diag[i] = d.get(i, i);
+                }
+                if (gmat::cholesky(d)) {
+                    ++m_fallbacks;
+                    d = gmat::dynmatrix<T>(size, size, T(0));
+                    for (size_t i = 0; i < size; ++i) {
+                        d.set(i, i, diag[i] > 0 ? std::sqrt(diag[i]) : T(1));
+                    }
+                }
+                m_first.push_back(first);
+                m_factors.push_back(std::move(d));
+            }
+        }
+
+        void apply(const gmat::dynmatrix<T>& r, gmat::dynmatrix<T>& z)
+        {
+            for (size_t b = 0; b < m_factors.size(); ++b) {
+                size_t size = m_factors[b].rows();
+                m_scratch.resize(size, 1);
+                std::copy_n(r.data() + m_first[b], size, m_scratch.data());
+                gmat::cholesky_solve(m_factors[b], m_scratch);
+                std::copy_n(m_scratch.data(), size, z.data() + m_first[b]);
+            }
+        }
+
+        /**
+        * @brief Number of blocks that were not positive definite and fell back to their diagonal.
+        */
+        size_t fallbacks() const
+        {
+            return m_fallbacks;
+        }
+
+    private:
+        std::vector<size_t> m_first;
+        std::vector<gmat::dynmatrix<T>> m_factors;
+        gmat::dynmatrix<T> m_scratch;
+        size_t m_fallbacks;
+    };
+
+    /**
+    * @brief Approximates A^-1 r by a fixed number of GaBP sweeps.
+    *
+    * Precision messages do not depend on the right-hand side, so they are
+    * run once on construction and turned into the gains of %solver::resolve().
+    * Each application then starts from zero h messages, runs a fixed
+    * number of synchronous h sweeps with r as right-hand side, and returns
+    * the means: a fixed linear map of r, cheap enough to apply at every
+    * iteration of %pcg. Zero sweeps divide by the GaBP marginal precisions.
+    * Prefer an even number of sweeps: one sweep of a diagonally weak
+    * system overshoots like a truncated Neumann series, the map is then
+    * indefinite, and conjugate gradients crawl.
+    *
+    * On matrices that are not walk-summable the precision messages may
+    * not converge or may turn non-positive. Variables whose precision is
+    * not positive and finite fall back to their diagonal entry and send
+    * no h messages, so the map stays defined.
+    */
+    template <typename T>
+    class gabp_preconditioner : protected solver<T> {
+    public:
+        /**
+        * @param mat Symmetric sparse %matrix A, which must outlive this.
+        * @param sweeps Number of h sweeps per application.
+        * @param opts options::max_iterations and options::tolerance bound
+        *             the precision sweeps run on construction.
+        */
+        gabp_preconditioner(const gmat::sparse_matrix<T>& mat, size_t sweeps, options<T> opts = options<T>())
+            : solver<T>(mat, opts), m_sweeps(sweeps), m_h(mat.nnz(), T(0)), m_h_next(mat.nnz(), T(0))
+        {
+            converge_precisions();
+            this->cache_gains();
+            const T* val = mat.values();
+            for (size_t i = 0; i < mat.rows(); ++i) {
+                T& p_i = this->m_precision[i];
+                bool bad = !(p_i > 0) || !std::isfinite(p_i);
+                for (size_t p = mat.offsets()[i]; p < mat.offsets()[i + 1]; ++p) {
+                    bad = bad || !std::isfinite(this->m_gain[p]);
+                }
+                if (bad) {
+                    size_t d = this->m_diag[i];
+                    p_i = d < mat.nnz() ? val[d] : T(1);
+                    for (size_t p = mat.offsets()[i]; p < mat.offsets()[i + 1]; ++p) {
+                        this->m_gain[p] = T(0);
+                    }
+                }
+            }
+        }
+
+        void apply(const gmat::dynmatrix<T>& r, gmat::dynmatrix<T>& z)
+        {
+            const auto& mat = this->m_mat;
+            const size_t* off = mat.offsets();
+            size_t n = mat.rows();
+            std::fill(m_h.begin(), m_h.end(), T(0));
+            for (size_t s = 0; s < m_sweeps; ++s) {
+                for (size_t i = 0; i < n; ++i) {
+                    T h_i = r[i];
+                    for (size_t p = off[i]; p < off[i + 1]; ++p) {
+                        h_i += m_h[p];
+                    }
+                    for (size_t p = off[i]; p < off[i + 1]; ++p) {
+                        // The diagonal slot has a zero gain and never receives a message.
+                        m_h_next[this->m_reverse[p]] = this->m_gain[p] * (h_i - m_h[p]);
+                    }
+                }
+                std::swap(m_h, m_h_next);
+            }
+            for (size_t i = 0; i < n; ++i) {
+                T h_i = r[i];
+                for (size_t p = off[i]; p < off[i + 1]; ++p) {
+                    h_i += m_h[p];
+                }
+                z[i] = h_i / this->m_precision[i];
+            }
+        }
+
+        /**
+        * @brief Number of precision sweeps run on construction.
+        */
+        size_t setup_sweeps() const
+        {
+            return this->m_iterations;
+        }
+
+    protected:
+        /**
+        * @brief Runs synchronous precision-only sweeps until they settle or max_iterations is reached.
+        */
+        void converge_precisions()
+        {
+            const auto& mat = this->m_mat;
+            const size_t* off = mat.offsets();
+            const T* val = mat.values();
+            std::vector<T>& prec = this->m_prec;
+            std::vector<T> next(mat.nnz(), T(0));
+            this->m_iterations = 0;
+            while (this->m_iterations < this->m_opts.max_iterations) {
+                ++this->m_iterations;
+                T change = 0;
+                for (size_t i = 0; i < mat.rows(); ++i) {
+                    size_t d = this->m_diag[i];
+                    T p_i = d < mat.nnz() ? val[d] : T(0);
+                    for (size_t p = off[i]; p < off[i + 1]; ++p) {
+                        p_i += prec[p];
+                    }
+                    for (size_t p = off[i]; p < off[i + 1]; ++p) {
+                        if (p == d) {
+                            continue;
+                        }
+                        size_t r = this->m_reverse[p];
+                        next[r] = -val[p] * val[p] / (p_i - prec[p]);
+                        change = std::max(change, std::abs(next[r] - prec[r]));
+                    }
+                }
+                std::swap(prec, next);
+                if (change < this->m_opts.tolerance) {
+                    break;
+                }
+            }
+        }
+
+        size_t m_sweeps;
+        std::vector<T> m_h, m_h_next;
+    };
+
+    /**
+    * @brief Preconditioned conjugate gradients for sparse symmetric positive definite systems A x = b.
+    * @tparam T Floating point type of elements.
+    *
+    * Any preconditioner with a member apply(r, z) that writes an
+    * approximation of A^-1 r to z can be used: %identity_preconditioner,
+    * %jacobi_preconditioner, %block_jacobi_preconditioner or
+    * %gabp_preconditioner. GaBP sweeps are a linear map but not always a
+    * symmetric one, so the flexible Polak-Ribiere form of beta is used,
+    * which costs one extra vector and keeps convergence in that case.
+    *
+    * @warning The %pcg keeps a reference to A, which must outlive it.
+    */
+    template <typename T>
+    class pcg {
+    public:
+        /**
+        * @param mat Symmetric positive definite sparse %matrix A.
+        * @param opts options::max_iterations bounds the number of
+        *             iterations, and the solve stops once |r| <= tolerance * |b|.
+        */
+        explicit pcg(const gmat::sparse_matrix<T>& mat, options<T> opts = options<T>())
+            : m_mat(mat), m_opts(opts), m_iterations(0), m_residual(0), m_seconds(0)
+        {
+            assert(mat.rows() == mat.cols());
+        }
+
+        /**
+        * @brief Solves A x = b from x = 0.
+        * @param b Right-hand side, an @a n*1 %dynmatrix.
+        * @param precond Preconditioner.
+        * @return true if the relative residual did not reach tolerance within max_iterations.
+        */
+        template <typename P>
+        bool solve(const gmat::dynmatrix<T>& b, P& precond)
+        {
+            assert(b.size() == m_mat.rows());
+            auto start = std::chrono::steady_clock::now();
+            size_t n = m_mat.rows();
+            m_x = gmat::dynmatrix<T>(n, 1, T(0));
+            gmat::dynmatrix<T> r = b.clone();
+            gmat::dynmatrix<T> r_old(n, 1), z(n, 1), p(n, 1), q(n, 1);
+            T norm_b = std::sqrt(dot(b, b));
+            T target = m_opts.tolerance * norm_b;
+            m_iterations = 0;
+            m_residual = norm_b > 0 ? T(1) : T(0);
+            bool failed = norm_b > 0;
+            T rz = 0;
+            while (failed && m_iterations < m_opts.max_iterations) {
+                precond.apply(r, z);
+                T rz_next = dot(r, z);
+                if (m_iterations == 0) {
+                    std::copy_n(z.data(), n, p.data());
+                } else {
+                    // Polak-Ribiere: z . (r - r_old) / (z_old . r_old).
+                    T beta = (rz_next - dot(z, r_old)) / rz;
+                    for (size_t i = 0; i < n; ++i) {
+                        p[i] = z[i] + beta * p[i];
+                    }
+                }
+                rz = rz_next;
+                gmat::spmv(m_mat, p, q);
+                T pq = dot(p, q);
+                if (!(pq > 0)) {
+                    break;
+                }
+                T alpha = rz / pq;
+                std::copy_n(r.data(), n, r_old.data());
+                for (size_t i = 0; i < n; ++i) {
+                    m_x[i] += alpha * p[i];
+                    r[i] -= alpha * q[i];
+                }
+                ++m_iterations;
+                T norm_r = std::sqrt(dot(r, r));
+                m_residual = norm_r / norm_b;
+                failed = norm_r > target;
+            }
+            m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            return failed;
+        }
+
+        /**
+        * @brief Solution of the last solve.
+        */
+        const gmat::dynmatrix<T>& solution() const
+        {
+            return m_x;
+        }
+
+        /**
+        * @brief Number of iterations run by the last solve.
+        */
+        size_t iterations() const
+        {
+            return m_iterations;
+        }
+
+        /**
+        * @brief Relative residual |b - A x| / |b| reached by the last solve.
+        */
+        T residual() const
+        {
+            return m_residual;
+        }
+
+        /**
+        * @brief Wall-clock time of the last solve in seconds, preconditioner applications included.
+        */
+        double seconds() const
+        {
+            return m_seconds;
+        }
+
+        const options<T>& opts() const
+        {
+            return m_opts;
+        }
+
+    protected:
+        static T dot(const gmat::dynmatrix<T>& a, const gmat::dynmatrix<T>& b)
+        {
+            return detail::dot(a.data(), b.data(), a.size());
+        }
+
+        const gmat::sparse_matrix<T>& m_mat;
+        options<T> m_opts;
+        gmat::dynmatrix<T> m_x;
+        size_t m_iterations;
+        T m_residual;
+        double m_seconds;
+    };
+}
+
+#endif // __PCG_HH__
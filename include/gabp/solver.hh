@@ -0,0 +1,833 @@
+#ifndef __SOLVER_HH__
+#define __SOLVER_HH__
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <deque>
+#include <limits>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gabp/accelerator.hh"
+#include "gabp/dynmatrix.hh"
+#include "gabp/parallel.hh"
+#include "gabp/sparse.hh"
+
+/**
+ * @brief The %gabp namespace includes the inference engines built on the %gmat backend.
+ */
+namespace gabp {
+    /**
+    * @brief Order in which a %solver updates messages.
+    */
+    enum class schedule {
+        /**
+        * @brief Every variable sends all its messages once per sweep, from the
+        *        messages of the previous sweep.
+        */
+        synchronous,
+
+        /**
+        * @brief The variable whose incoming messages changed the most is
+        *        updated next, in place, so converged regions stop consuming
+        *        work. Stops once no pending change reaches the tolerance.
+        */
+        residual,
+
+        /**
+        * @brief Variables are updated asynchronously, in place, by
+        *        options::threads workers that balance load by work stealing.
+        *        A variable is queued again on the worker that changed one of
+        *        its incoming messages by at least the tolerance, and the solve
+        *        ends when no variable is queued.
+        */
+        work_stealing
+    };
+
+    /**
+    * @brief Tuning parameters of a %solver.
+    * @tparam T Type of elements.
+    */
+    template <typename T>
+    struct options {
+        /**
+        * @brief Largest number of sweeps over the graph before giving up.
+        */
+        size_t max_iterations = 100;
+
+        /**
+        * @brief Convergence threshold on the largest change of any mean between two sweeps.
+        */
+        T tolerance = T(1e-6);
+
+        /**
+        * @brief Message update order.
+        *
+        * Under schedule::residual and schedule::work_stealing,
+        * max_iterations bounds the number of variable updates to
+        * max_iterations times the number of variables.
+        */
+        schedule policy = schedule::synchronous;
+
+        /**
+        * @brief Number of worker threads for schedule::synchronous and
+        *        schedule::work_stealing, 0 for one per hardware thread.
+        *
+        * Synchronous results do not depend on the thread count.
+        */
+        size_t threads = 1;
+
+        /**
+        * @brief Extrapolation of the h messages between synchronous sweeps.
+        *
+        * Ignored by the other schedules. See %accelerator.
+        */
+        acceleration accelerate = acceleration::none;
+
+        /**
+        * @brief Number of past sweeps acceleration::anderson combines.
+        */
+        size_t acceleration_window = 5;
+
+        /**
+        * @brief Number of sweeps per accelerated step; see %accelerator.
+        */
+        size_t acceleration_interval = 4;
+    };
+
+    namespace detail {
+        /**
+        * @brief Pairs every entry of a structurally symmetric CSR pattern with its transpose.
+        * @param n Number of rows.
+        * @param off,idx CSR offsets and column indices.
+        * @param reverse Receives, for each position of an entry i,j, the position of entry j,i.
+        * @param diag Receives the position of the diagonal entry of each row, or nnz if absent.
+        *
+        * O(nnz): rows are visited in increasing order, and so are the columns
+        * within each row, so entry j,i is always the next unvisited one in row j.
+        */
+        template <typename I>
+        void pair_edges(size_t n, const size_t* off, const I* idx,
+                        std::vector<size_t>& reverse, std::vector<size_t>& diag)
+        {
+            reverse.resize(off[n]);
+            diag.assign(n, off[n]);
+            std::vector<size_t> next(off, off + n);
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t p = off[i]; p < off[i + 1]; ++p) {
+                    size_t j = idx[p];
+                    if (j == i) {
+                        diag[i] = p;
+                    }
+                    assert(next[j] < off[j + 1] && idx[next[j]] == i);
+                    reverse[p] = next[j]++;
+                }
+            }
+        }
+    }
+
+    /**
+    * @brief Scalar Gaussian Belief Propagation solver for sparse symmetric systems A x = b.
+    * @tparam T Floating point type of elements.
+    *
+    * Each variable i of the graph is a row of A, and each stored off-diagonal
+    * entry A_ij an edge. Every edge carries a precision message and a
+    * precision-weighted mean message (h = P * mu). The message sent from j to
+    * i is stored at the position of entry i,j in the CSR arrays, so the
+    * incoming messages of a variable are contiguous and a sweep reads memory
+    * linearly.
+    *
+    * On convergence mean() is the solution x. The marginal precisions are
+    * exact on trees and approximations on loopy graphs.
+    *
+    * @pre A is symmetric, with every diagonal entry stored.
+    * @warning The %solver keeps a reference to A, which must outlive it.
+    */
+    template <typename T>
+    class solver {
+    public:
+        typedef gmat::sparse_matrix<T> matrix_type;
+
+        /**
+        * @brief Creates a %solver for a fixed system matrix.
+        * @param mat Symmetric sparse %matrix A in CSR layout.
+        * @param opts Tuning parameters.
+        *
+        * Pairs every edge with its reverse in O(nnz).
+        */
+        explicit solver(const matrix_type& mat, options<T> opts = options<T>())
+            : m_mat(mat), m_opts(opts), m_iterations(0), m_updates(0), m_residual(0)
+        {
+            assert(mat.rows() == mat.cols());
+            detail::pair_edges(mat.rows(), mat.offsets(), mat.indices(), m_reverse, m_diag);
+            reset();
+        }
+
+        /**
+        * @brief Clears all messages, so the next solve starts from scratch.
+        */
+        void reset()
+        {
+            m_prec.assign(m_mat.nnz(), T(0));
+            m_h.assign(m_mat.nnz(), T(0));
+            m_mean = gmat::dynmatrix<T>(m_mat.rows(), 1, T(0));
+            m_precision = gmat::dynmatrix<T>(m_mat.rows(), 1, T(0));
+            m_iterations = 0;
+            m_updates = 0;
+            m_converged = false;
+            m_gain.clear();
+        }
+
+        /**
+        * @brief Runs message passing for A x = b with the configured schedule.
+        * @param b Right-hand side, an @a n*1 %dynmatrix.
+        * @return true if the means did not converge within max_iterations.
+        *         false if they converged to tolerance.
+        *
+        * Starts from the messages left by the previous solve, if any.
+        */
+        bool solve(const gmat::dynmatrix<T>& b)
+        {
+            assert(b.size() == m_mat.rows());
+            m_updates = 0;
+            m_gain.clear();
+            if (m_mean.cols() != 1) {
+                m_mean = gmat::dynmatrix<T>(m_mat.rows(), 1, T(0));
+            }
+            bool failed;
+            switch (m_opts.policy) {
+            case schedule::residual:
+                failed = solve_residual(b);
+                break;
+            case schedule::work_stealing:
+                failed = solve_work_stealing(b);
+                break;
+            case schedule::synchronous:
+            default:
+                failed = solve_synchronous(b);
+                break;
+            }
+            m_rhs = b.clone();
+            m_converged = !failed;
+            return failed;
+        }
+
+        /**
+        * @brief Solves A x = b again after a change of b only, reusing the converged precisions.
+        * @param b New right-hand side, an @a n*1 %dynmatrix.
+        * @return true if the means did not converge within max_iterations.
+        *         false if they converged to tolerance.
+        *
+        * Precision messages do not depend on b, so once a solve has
+        * converged they are kept, and each h message becomes a fixed
+        * multiple of its sender's cavity h. Starting from the previous h
+        * messages, only variables whose entry of b changed are updated at
+        * first; a variable is updated again only when an incoming h message
+        * changes by at least the tolerance. Regions the change does not reach
+        * cost nothing, and the same b twice costs O(n) to compare.
+        *
+        * Falls back to solve() if no solve has converged since the last
+        * reset(). max_iterations bounds the number of variable updates to
+        * max_iterations times the number of variables, and residual()
+        * reports the largest h message change that was not propagated.
+        */
+        bool resolve(const gmat::dynmatrix<T>& b)
+        {
+            assert(b.size() == m_mat.rows());
+            if (!m_converged) {
+                return solve(b);
+            }
+            size_t n = m_mat.rows();
+            const size_t* off = m_mat.offsets();
+            if (m_gain.empty()) {
+                cache_gains();
+            }
+
+            std::deque<size_t> queue;
+            std::vector<char> queued(n, 0), touched(n, 0);
+            for (size_t i = 0; i < n; ++i) {
+                if (b[i] != m_rhs[i]) {
+                    queue.push_back(i);
+                    queued[i] = touched[i] = 1;
+                }
+            }
+            m_rhs = b.clone();
+
+            size_t budget = m_opts.max_iterations * n;
+            size_t runs = 0;
+            m_updates = 0;
+            m_residual = 0;
+            while (!queue.empty() && runs < budget) {
+                size_t i = queue.front();
+                queue.pop_front();
+                queued[i] = 0;
+                ++runs;
+                T h_i = b[i];
+                for (size_t p = off[i]; p < off[i + 1]; ++p) {
+                    h_i += m_h[p];
+                }
+                m_mean[i] = h_i / m_precision[i];
+                for (size_t p = off[i]; p < off[i + 1]; ++p) {
+                    if (p == m_diag[i]) {
+                        continue;
+                    }
+                    size_t r = m_reverse[p];
+                    T h = m_gain[p] * (h_i - m_h[p]);
+                    T delta = std::abs(h - m_h[r]);
+                    m_h[r] = h;
+                    ++m_updates;
+                    size_t j = m_mat.indices()[p];
+                    touched[j] = 1;
+                    if (delta < m_opts.tolerance) {
+                        m_residual = std::max(m_residual, delta);
+                    } else if (!queued[j]) {
+                        queued[j] = 1;
+                        queue.push_back(j);
+                    }
+                }
+            }
+
+            bool failed = !queue.empty();
+            if (failed) {
+                m_residual = std::max(m_residual, m_opts.tolerance);
+            }
+            for (size_t i = 0; i < n; ++i) {
+                if (touched[i]) {
+                    T h_i = b[i];
+                    for (size_t p = off[i]; p < off[i + 1]; ++p) {
+                        h_i += m_h[p];
+                    }
+                    m_mean[i] = h_i / m_precision[i];
+                }
+            }
+            m_iterations = (runs + n - 1) / std::max<size_t>(n, 1);
+            m_converged = !failed;
+            return failed;
+        }
+
+        /**
+        * @brief Solves A X = B for k right-hand sides at once with synchronous sweeps.
+        * @param b Right-hand sides, an @a n*k %dynmatrix with one column per system.
+        * @return true if some mean did not converge within max_iterations.
+        *         false if all converged to tolerance.
+        *
+        * Precision messages do not depend on b, so each edge carries one
+        * precision message and a row of k h messages. A variable update
+        * gathers its precision and cavity precisions once and turns each
+        * into a gain, -A_ij / (P_i - P_ji), that scales all k cavity h
+        * entries; the k-wide rows are contiguous, so these inner loops
+        * vectorize and the graph is traversed once per sweep rather than
+        * once per right-hand side.
+        *
+        * mean() is then the @a n*k solution X. Starts from the precision
+        * messages left by the previous solve, if any, and from zero h
+        * messages. options::policy and options::threads are ignored, and
+        * updates() counts an edge once per sweep whatever k is. resolve()
+        * falls back to solve() after a batched solve.
+        */
+        bool solve_batch(const gmat::dynmatrix<T>& b)
+        {
+            assert(b.rows() == m_mat.rows());
+            size_t n = m_mat.rows();
+            size_t k = b.cols();
+            size_t nnz = m_mat.nnz();
+            const size_t* off = m_mat.offsets();
+            const T* val = m_mat.values();
+            std::vector<T> prec_next(nnz, T(0));
+            std::vector<T> h(nnz * k, T(0)), h_next(nnz * k, T(0));
+            std::vector<T> h_i(k);
+            m_mean = gmat::dynmatrix<T>(n, k, T(0));
+            m_gain.clear();
+            m_converged = false;
+            m_iterations = 0;
+            m_updates = 0;
+            while (m_iterations < m_opts.max_iterations) {
+                ++m_iterations;
+                T change = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    size_t d = m_diag[i];
+                    T p_i = d < nnz ? val[d] : T(0);
+                    std::copy_n(b.data() + i * k, k, h_i.data());
+                    for (size_t p = off[i]; p < off[i + 1]; ++p) {
+                        p_i += m_prec[p];
+                        const T* hp = h.data() + p * k;
+                        for (size_t c = 0; c < k; ++c) {
+                            h_i[c] += hp[c];
+                        }
+                    }
+                    m_precision[i] = p_i;
+                    for (size_t p = off[i]; p < off[i + 1]; ++p) {
+                        if (p == d) {
+                            continue;
+                        }
+                        size_t r = m_reverse[p];
+                        T gain = -val[p] / (p_i - m_prec[p]);
+                        prec_next[r] = gain * val[p];
+                        const T* hp = h.data() + p * k;
+                        T* out = h_next.data() + r * k;
+                        for (size_t c = 0; c < k; ++c) {
+                            out[c] = gain * (h_i[c] - hp[c]);
+                        }
+                    }
+                    T* mu = m_mean.data() + i * k;
+                    for (size_t c = 0; c < k; ++c) {
+                        T x = h_i[c] / p_i;
+                        change = std::max(change, std::abs(x - mu[c]));
+                        mu[c] = x;
+                    }
+                }
+                std::swap(m_prec, prec_next);
+                std::swap(h, h_next);
+                m_updates += nnz - n;
+                m_residual = change;
+                if (change < m_opts.tolerance) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+        * @brief Per-variable means, the solution x once converged; @a n*k after solve_batch().
+        */
+        const gmat::dynmatrix<T>& mean() const
+        {
+            return m_mean;
+        }
+
+        /**
+        * @brief Per-variable marginal precisions.
+        */
+        const gmat::dynmatrix<T>& precision() const
+        {
+            return m_precision;
+        }
+
+        /**
+        * @brief Number of sweeps run by the last solve.
+        */
+        size_t iterations() const
+        {
+            return m_iterations;
+        }
+
+        /**
+        * @brief Number of messages computed by the last solve.
+        */
+        size_t updates() const
+        {
+            return m_updates;
+        }
+
+        /**
+        * @brief Convergence measure reached by the last solve.
+        *
+        * The largest change of any mean during the last sweep under
+        * schedule::synchronous; the largest pending message change under
+        * schedule::residual.
+        */
+        T residual() const
+        {
+            return m_residual;
+        }
+
+        const options<T>& opts() const
+        {
+            return m_opts;
+        }
+
+    protected:
+        /**
+        * @brief Sweeps all variables, double-buffering the messages.
+        *
+        * Each sweep computes every outgoing message from the messages of the
+        * previous sweep, then compares the means. Unless converged, the h
+        * messages may then be extrapolated by options::accelerate.
+        */
+        bool solve_synchronous(const gmat::dynmatrix<T>& b)
+        {
+            size_t n = m_mat.rows();
+            size_t threads = std::min(detail::thread_count(m_opts.threads), n);
+            if (threads > 1 && m_opts.max_iterations > 0) {
+                return solve_parallel(b, threads);
+            }
+            std::vector<T> prec_next(m_mat.nnz(), T(0));
+            std::vector<T> h_next(m_mat.nnz(), T(0));
+            accelerator<T> acc = make_accelerator();
+            m_iterations = 0;
+            while (m_iterations < m_opts.max_iterations) {
+                ++m_iterations;
+                T change = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    T mu = update(i, b[i], m_prec, m_h, [&](size_t r, size_t, T prec, T h) {
+                        prec_next[r] = prec;
+                        h_next[r] = h;
+                    });
+                    change = std::max(change, std::abs(mu - m_mean[i]));
+                    m_mean[i] = mu;
+                }
+                std::swap(m_prec, prec_next);
+                std::swap(m_h, h_next);
+                m_updates += m_mat.nnz() - n;
+                m_residual = change;
+                if (change < m_opts.tolerance) {
+                    return false;
+                }
+                acc.apply(m_h.data());
+            }
+            return true;
+        }
+
+        /**
+        * @brief Creates the %accelerator of the h messages for a synchronous solve.
+        */
+        accelerator<T> make_accelerator() const
+        {
+            accelerator<T> acc(m_opts.accelerate, m_opts.accelerate == acceleration::none ? 0 : m_h.size(),
+                               m_opts.acceleration_window, m_opts.acceleration_interval);
+            acc.start(m_h.data());
+            return acc;
+        }
+
+        /**
+        * @brief Synchronous sweeps split across threads.
+        *
+        * Rows are partitioned into contiguous ranges of equal work. Every
+        * message slot of the next buffer has a single writer, its sender, and
+        * the current buffer is only read, so the sweep needs no locks. A
+        * barrier ends each sweep; the first thread then swaps the buffers and
+        * decides whether to stop, and a second barrier publishes that.
+        */
+        bool solve_parallel(const gmat::dynmatrix<T>& b, size_t threads)
+        {
+            struct alignas(detail::cache_line) slot {
+                T change;
+            };
+            std::vector<size_t> bounds = detail::partition(m_mat.offsets(), m_mat.rows(), threads);
+            std::vector<slot> changes(threads);
+            std::vector<T> prec_next(m_mat.nnz(), T(0));
+            std::vector<T> h_next(m_mat.nnz(), T(0));
+            detail::barrier sync(threads);
+            accelerator<T> acc = make_accelerator();
+            bool done = false;
+            bool converged = false;
+            m_iterations = 0;
+
+            auto work = [&](size_t t) {
+                for (;;) {
+                    T change = 0;
+                    for (size_t i = bounds[t]; i < bounds[t + 1]; ++i) {
+                        T mu = update(i, b[i], m_prec, m_h, [&](size_t r, size_t, T prec, T h) {
+                            prec_next[r] = prec;
+                            h_next[r] = h;
+                        });
+                        change = std::max(change, std::abs(mu - m_mean[i]));
+                        m_mean[i] = mu;
+                    }
+                    changes[t].change = change;
+                    sync.wait();
+                    if (t == 0) {
+                        std::swap(m_prec, prec_next);
+                        std::swap(m_h, h_next);
+                        ++m_iterations;
+                        m_residual = 0;
+                        for (const slot& c : changes) {
+                            m_residual = std::max(m_residual, c.change);
+                        }
+                        converged = m_residual < m_opts.tolerance;
+                        done = converged || m_iterations >= m_opts.max_iterations;
+                        if (!done) {
+                            acc.apply(m_h.data());
+                        }
+                    }
+                    sync.wait();
+                    if (done) {
+                        return;
+                    }
+                }
+            };
+
+            std::vector<std::thread> workers;
+            workers.reserve(threads - 1);
+            for (size_t t = 1; t < threads; ++t) {
+                workers.emplace_back(work, t);
+            }
+            work(0);
+            for (std::thread& w : workers) {
+                w.join();
+            }
+            m_updates += m_iterations * (m_mat.nnz() - m_mat.rows());
+            return !converged;
+        }
+
+        /**
+        * @brief Updates variables in order of decreasing residual, in place.
+        *
+        * The residual of a variable is the largest change of any message it
+        * received since it was last updated. A max-heap with lazy deletion
+        * keeps the pending variables; stale heap entries are skipped.
+        */
+        bool solve_residual(const gmat::dynmatrix<T>& b)
+        {
+            size_t n = m_mat.rows();
+            std::vector<T> priority(n, std::numeric_limits<T>::infinity());
+            std::priority_queue<std::pair<T, size_t>> heap;
+            for (size_t i = 0; i < n; ++i) {
+                heap.emplace(priority[i], i);
+            }
+            size_t budget = m_opts.max_iterations * n;
+            size_t done = 0;
+            bool converged = true;
+            while (!heap.empty()) {
+                auto top = heap.top();
+                size_t i = top.second;
+                if (top.first != priority[i]) {
+                    heap.pop();
+                    continue;
+                }
+                if (top.first < m_opts.tolerance) {
+                    break;
+                }
+                if (done == budget) {
+                    converged = false;
+                    break;
+                }
+                heap.pop();
+                priority[i] = T(0);
+                m_mean[i] = update(i, b[i], m_prec, m_h, [&](size_t r, size_t j, T prec, T h) {
+                    T delta = std::max(std::abs(prec - m_prec[r]), std::abs(h - m_h[r]));
+                    m_prec[r] = prec;
+                    m_h[r] = h;
+                    ++m_updates;
+                    if (delta > priority[j]) {
+                        priority[j] = delta;
+                        heap.emplace(delta, j);
+                    }
+                });
+                ++done;
+            }
+            m_iterations = (done + n - 1) / std::max<size_t>(n, 1);
+            m_residual = 0;
+            for (size_t i = 0; i < n; ++i) {
+                m_residual = std::max(m_residual, priority[i]);
+                m_mean[i] = marginal(i, b[i]);
+            }
+            return !converged;
+        }
+
+        /**
+        * @brief Updates variables asynchronously on a work-stealing pool.
+        *
+        * Messages are copied into arrays of relaxed atomics that workers
+        * overwrite in place. Each worker starts with a contiguous range of
+        * variables of about equal work. A final pass over the converged
+        * messages computes the means and the largest message change one more
+        * update would make, which is reported as the residual.
+        */
+        bool solve_work_stealing(const gmat::dynmatrix<T>& b)
+        {
+            struct window {
+                const T* data;
+                size_t first;
+
+                T operator[](size_t p) const
+                {
+                    return data[p - first];
+                }
+            };
+            struct alignas(detail::cache_line) slot {
+                size_t updates;
+            };
+            size_t n = m_mat.rows();
+            size_t nnz = m_mat.nnz();
+            size_t threads = std::max<size_t>(std::min(detail::thread_count(m_opts.threads), n), 1);
+            detail::relaxed_array<T> prec(nnz), h(nnz);
+            for (size_t p = 0; p < nnz; ++p) {
+                prec.store(p, m_prec[p]);
+                h.store(p, m_h[p]);
+            }
+
+            detail::work_stealing pool(threads, n);
+            std::vector<size_t> bounds = detail::partition(m_mat.offsets(), n, threads);
+            for (size_t t = 0; t < threads; ++t) {
+                for (size_t i = bounds[t]; i < bounds[t + 1]; ++i) {
+                    pool.schedule(t, i);
+                }
+            }
+
+            std::vector<slot> counts(threads, slot{0});
+            std::vector<std::vector<T>> in_prec(threads), in_h(threads);
+            std::atomic<size_t> done(0);
+            size_t budget = m_opts.max_iterations * n;
+            T tol = m_opts.tolerance;
+            const size_t* off = m_mat.offsets();
+            pool.run([&](size_t w, size_t i) {
+                if (done.fetch_add(1, std::memory_order_relaxed) >= budget) {
+                    pool.stop();
+                    return;
+                }
+                // Neighbors may overwrite the incoming messages meanwhile, and
+                // update() reads each one twice, so work on a snapshot.
+                size_t first = off[i];
+                size_t degree = off[i + 1] - first;
+                in_prec[w].resize(degree);
+                in_h[w].resize(degree);
+                for (size_t k = 0; k < degree; ++k) {
+                    in_prec[w][k] = prec[first + k];
+                    in_h[w][k] = h[first + k];
+                }
+                window snap_prec{in_prec[w].data(), first}, snap_h{in_h[w].data(), first};
+                update(i, b[i], snap_prec, snap_h, [&](size_t r, size_t j, T pv, T hv) {
+                    T delta = std::max(std::abs(pv - prec[r]), std::abs(hv - h[r]));
+                    prec.store(r, pv);
+                    h.store(r, hv);
+                    ++counts[w].updates;
+                    if (delta >= tol) {
+                        pool.schedule(w, j);
+                    }
+                });
+            });
+
+            for (size_t p = 0; p < nnz; ++p) {
+                m_prec[p] = prec[p];
+                m_h[p] = h[p];
+            }
+            for (const slot& c : counts) {
+                m_updates += c.updates;
+            }
+            size_t runs = std::min(done.load(), budget);
+            m_iterations = (runs + n - 1) / std::max<size_t>(n, 1);
+            m_residual = 0;
+            for (size_t i = 0; i < n; ++i) {
+                m_mean[i] = update(i, b[i], m_prec, m_h, [&](size_t r, size_t, T pv, T hv) {
+                    m_residual = std::max(m_residual, std::max(std::abs(pv - m_prec[r]), std::abs(hv - m_h[r])));
+                });
+            }
+            return pool.stopped();
+        }
+
+        /**
+        * @brief Freezes the precision messages for resolve().
+        *
+        * Recomputes the marginal precisions from the current messages and
+        * caches, for every entry i,j, the factor -A_ij / (P_i - P_ji) that
+        * maps the cavity h of i to its h message to j.
+        */
+        void cache_gains()
+        {
+            const size_t* off = m_mat.offsets();
+            const T* val = m_mat.values();
+            m_gain.assign(m_mat.nnz(), T(0));
+            for (size_t i = 0; i < m_mat.rows(); ++i) {
+                size_t d = m_diag[i];
+                T p_i = d < m_mat.nnz() ? val[d] : T(0);
+                for (size_t p = off[i]; p < off[i + 1]; ++p) {
+                    p_i += m_prec[p];
+                }
+                m_precision[i] = p_i;
+                for (size_t p = off[i]; p < off[i + 1]; ++p) {
+                    if (p != d) {
+                        m_gain[p] = -val[p] / (p_i - m_prec[p]);
+                    }
+                }
+            }
+        }
+
+        /**
+        * @brief Gathers the incoming messages of variable i and sends its outgoing messages.
+        * @param i Variable.
+        * @param bi Right-hand side of variable i.
+        * @param prec,h Incoming messages, indexed like the entries of A.
+        * @param emit Called as emit(r, j, prec, h) for the message to each
+        *             neighbor j, where r is the slot it belongs in.
+        * @return The mean of variable i given its incoming messages.
+        *
+        * For each neighbor j, the message i->j excludes what j sent to i:
+        * P_ij = -A_ij^2 / (P_i - P_ji) and h_ij = -A_ij (h_i - h_ji) / (P_i - P_ji).
+        */
+        template <typename M, typename F>
+        T update(size_t i, T bi, const M& prec, const M& h, F&& emit)
+        {
+            const size_t* off = m_mat.offsets();
+            const auto* idx = m_mat.indices();
+            const T* val = m_mat.values();
+            size_t d = m_diag[i];
+            T p_i = d < m_mat.nnz() ? val[d] : T(0);
+            T h_i = bi;
+            for (size_t p = off[i]; p < off[i + 1]; ++p) {
+                p_i += prec[p];
+                h_i += h[p];
+            }
+            // The diagonal slot never receives a message, so it adds zero above.
+            m_precision[i] = p_i;
+            for (size_t p = off[i]; p < off[i + 1]; ++p) {
+                if (p == d) {
+                    continue;
+                }
+                T p_excl = p_i - prec[p];
+                T h_excl = h_i - h[p];
+                T a = val[p];
+                emit(m_reverse[p], size_t(idx[p]), -a * a / p_excl, -a * h_excl / p_excl);
+            }
+            return h_i / p_i;
+        }
+
+        /**
+        * @brief Mean of variable i from its incoming messages, without sending any.
+        */
+        T marginal(size_t i, T bi)
+        {
+            const size_t* off = m_mat.offsets();
+            size_t d = m_diag[i];
+            T p_i = d < m_mat.nnz() ? m_mat.values()[d] : T(0);
+            T h_i = bi;
+            for (size_t p = off[i]; p < off[i + 1]; ++p) {
+                p_i += m_prec[p];
+                h_i += m_h[p];
+            }
+            m_precision[i] = p_i;
+            return h_i / p_i;
+        }
+
+        const matrix_type& m_mat;
+        options<T> m_opts;
+
+        /**
+        * @brief Position of entry j,i for the entry i,j stored at each position.
+        */
+        std::vector<size_t> m_reverse;
+
+        /**
+        * @brief Position of the diagonal entry of each row, or nnz() if it is not stored.
+        */
+        std::vector<size_t> m_diag;
+
+        /**
+        * @brief Incoming precision and h messages, indexed like the entries of A.
+        */
+        std::vector<T> m_prec, m_h;
+
+        gmat::dynmatrix<T> m_mean, m_precision;
+        size_t m_iterations;
+        size_t m_updates;
+        T m_residual;
+
+        /**
+        * @brief Right-hand side of the last solve, and whether it converged.
+        */
+        gmat::dynmatrix<T> m_rhs;
+        bool m_converged = false;
+
+        /**
+        * @brief Cached h message factors for resolve(), empty until needed.
+        */
+        std::vector<T> m_gain;
+    };
+}
+
+#endif // __SOLVER_HH__
@@ -0,0 +1,469 @@
+#ifndef __SPARSE_HH__
+#define __SPARSE_HH__
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "gabp/dynmatrix.hh"
+
+namespace gmat {
+    /**
+    * @brief Storage order of a %sparse_matrix.
+    */
+    enum class sparse_layout {
+        csr, ///< Compressed sparse rows: entries grouped by row, sorted by column.
+        csc  ///< Compressed sparse columns: entries grouped by column, sorted by row.
+    };
+
+    /**
+    * @brief Entry of a %sparse_matrix seen from one outer index (a row in CSR, a column in CSC).
+    */
+    template <typename T>
+    struct sparse_entry {
+        /**
+        * @brief Inner index: the column in CSR, the row in CSC.
+        */
+        size_t index;
+
+        /**
+        * @brief Position of the entry in the value and index arrays.
+        */
+        size_t position;
+
+        /**
+        * @brief Value of the entry.
+        */
+        const T& value;
+    };
+
+    /**
+    * @brief Read-only range over the stored entries of one row (CSR) or column (CSC).
+    *
+    * Walks the index and value arrays of the parent %sparse_matrix in place.
+    */
+    template <typename T, typename I>
+    class sparse_slice {
+    public:
+        class iterator {
+        public:
+            iterator(const sparse_slice* slice, size_t k) : m_slice(slice), m_k(k) { }
+
+            sparse_entry<T> operator*() const
+            {
+                return m_slice->entry(m_k);
+            }
+
+            iterator& operator++()
+            {
+                ++m_k;
+                return *this;
+            }
+
+            bool operator!=(const iterator& other) const
+            {
+                return m_k != other.m_k;
+            }
+
+        private:
+            const sparse_slice* m_slice;
+            size_t m_k;
+        };
+
+        sparse_slice(size_t begin, size_t end, const I* indices, const T* values)
+            : m_begin(begin), m_end(end), m_indices(indices), m_values(values) { }
+
+        /**
+        * @brief Number of stored entries in the slice.
+        */
+        size_t size() const
+        {
+            return m_end - m_begin;
+        }
+
+        /**
+        * @brief The k-th stored entry of the slice.
+        */
+        sparse_entry<T> entry(size_t k) const
+        {
+            size_t p = m_begin + k;
+            return sparse_entry<T>{ m_indices[p], p, m_values[p] };
+        }
+
+        iterator begin() const
+        {
+            return iterator(this, 0);
+        }
+
+        iterator end() const
+        {
+            return iterator(this, size());
+        }
+
+    private:
+        size_t m_begin, m_end;
+        const I* m_indices;
+        const T* m_values;
+    };
+
+    /**
+    * @brief Compressed sparse %matrix.
+    * @tparam T Type of elements.
+    * @tparam L Storage order, CSR (default) or CSC.
+    *
+    * Stores an @a outer_size()+1 offset array, and one inner index and one
+    * value per stored entry, so memory scales with nnz(). Inner indices are
+    * sorted and unique within each row (CSR) or column (CSC). Build one from
+    * unordered triplets with %coo_builder.
+    */
+    template <typename T, sparse_layout L = sparse_layout::csr>
+    class sparse_matrix {
+    public:
+        typedef T value_type;
+        typedef std::uint32_t index_type;
+        static constexpr sparse_layout layout = L;
+
+        /**
+        * @brief Creates an empty 0*0 %sparse_matrix.
+        */
+        sparse_matrix() : m_rows(0), m_cols(0), m_offsets(1, 0) { }
+
+        /**
+        * @brief Creates a %sparse_matrix by adopting already compressed arrays.
+        * @param rows Number of rows.
+        * @param cols Number of columns.
+        * @param offsets @a outer_size()+1 offsets of each row (CSR) or column (CSC) into indices and values.
+        * @param indices Inner index of each entry, sorted within each row or column.
+        * @param values Value of each entry.
+        */
+        sparse_matrix(size_t rows, size_t cols, std::vector<size_t> offsets,
+                      std::vector<index_type> indices, std::vector<T> values)
+            : m_rows(rows), m_cols(cols), m_offsets(std::move(offsets)),
+              m_indices(std::move(indices)), m_values(std::move(values))
+        {
+            assert(m_offsets.size() == outer_size() + 1);
+            assert(m_indices.size() == m_values.size() && m_offsets.back() == m_values.size());
+        }
+
+        size_t rows() const
+        {
+            return m_rows;
+        }
+
+        size_t cols() const
+        {
+            return m_cols;
+        }
+
+        /**
+        * @brief Number of stored entries.
+        */
+        size_t nnz() const
+        {
+            return m_values.size();
+        }
+
+        /**
+        * @brief Number of rows in CSR, of columns in CSC.
+        */
+        size_t outer_size() const
+        {
+            return L == sparse_layout::csr ? m_rows : m_cols;
+        }
+
+        /**
+        * @brief Stored entries of row i (CSR) or column i (CSC).
+        * @param i Outer index.
+        * @return Range over the entries, in increasing inner index order.
+        */
+        sparse_slice<T, index_type> neighbors(size_t i) const
+        {
+            return sparse_slice<T, index_type>(m_offsets[i], m_offsets[i + 1], m_indices.data(), m_values.data());
+        }
+
+        /**
+        * @brief Position of entry i,j in the value array.
+        * @return The position, or nnz() if the entry is not stored.
+        */
+        size_t find(size_t i, size_t j) const
+        {
+            size_t outer = L == sparse_layout::csr ? i : j;
+            size_t inner = L == sparse_layout::csr ? j : i;
+            auto first = m_indices.begin() + m_offsets[outer];
+            auto last = m_indices.begin() + m_offsets[outer + 1];
+            auto it = std::lower_bound(first, last, inner);
+            return it != last && *it == inner ? size_t(it - m_indices.begin()) : nnz();
+        }
+
+        /**
+        * @brief Gets the value of the element at coordinate i,j.
+        * @return Value at i,j, or zero if it is not stored.
+        *
+        * Binary search within the row or column.
+        */
+        T get(size_t i, size_t j) const
+        {
+            size_t p = find(i, j);
+            return p == nnz() ? T(0) : m_values[p];
+        }
+
+        const size_t* offsets() const
+        {
+            return m_offsets.data();
+        }
+
+        const index_type* indices() const
+        {
+            return m_indices.data();
+        }
+
+        const T* values() const
+        {
+            return m_values.data();
+        }
+
+        T* values()
+        {
+            return m_values.data();
+        }
+
+        /**
+        * @brief Transposes the %matrix, switching to the other layout.
+        * @return A^T, sharing no storage with this %matrix.
+        *
+        * CSR storage of A is exactly CSC storage of A^T, so this only copies the arrays.
+        */
+        sparse_matrix<T, L == sparse_layout::csr ? sparse_layout::csc : sparse_layout::csr> transposed() const
+        {
+            return { m_cols, m_rows, m_offsets, m_indices, m_values };
+        }
+
+        /**
+        * @brief Converts to the other storage layout.
+        * @return The same %matrix, compressed along the other dimension.
+        *
+        * A counting sort over the inner indices, O(nnz + rows + cols).
+        */
+        sparse_matrix<T, L == sparse_layout::csr ? sparse_layout::csc : sparse_layout::csr> convert() const
+        {
+            size_t inner_size = L == sparse_layout::csr ? m_cols : m_rows;
+            std::vector<size_t> offsets(inner_size + 1, 0);
+            for (index_type k : m_indices) {
+                ++offsets[k + 1];
+            }
+            for (size_t i = 0; i < inner_size; ++i) {
+                offsets[i + 1] += offsets[i];
+            }
+            std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+            std::vector<index_type> indices(nnz());
+            std::vector<T> values(nnz());
+            for (size_t outer = 0; outer < outer_size(); ++outer) {
+                for (size_t p = m_offsets[outer]; p < m_offsets[outer + 1]; ++p) {
+                    size_t q = next[m_indices[p]]++;
+                    indices[q] = index_type(outer);
+                    values[q] = m_values[p];
+                }
+            }
+            return { m_rows, m_cols, std::move(offsets), std::move(indices), std::move(values) };
+        }
+
+    private:
+        size_t m_rows, m_cols;
+        std::vector<size_t> m_offsets;
+        std::vector<index_type> m_indices;
+        std::vector<T> m_values;
+    };
+
+    /**
+    * @brief Accumulates (row, column, value) triplets and compresses them into a %sparse_matrix.
+    * @tparam T Type of elements.
+    *
+    * Triplets may be added in any order. Duplicates are summed when the
+    * %matrix is built.
+    */
+    template <typename T>
+    class coo_builder {
+    public:
+        typedef std::uint32_t index_type;
+
+        /**
+        * @brief Creates an empty %coo_builder.
+        * @param rows Number of rows of the %matrix to build.
+        * @param cols Number of columns of the %matrix to build.
+        */
+        coo_builder(size_t rows, size_t cols) : m_rows(rows), m_cols(cols) { }
+
+        /**
+        * @brief Reserves space for a number of triplets.
+        */
+        void reserve(size_t count)
+        {
+            m_row.reserve(count);
+            m_col.reserve(count);
+            m_values.reserve(count);
+        }
+
+        /**
+        * @brief Adds value to the element at coordinate i,j.
+        * @pre i < rows, j < cols
+        */
+        void add(size_t i, size_t j, const T& value)
+        {
+            assert(i < m_rows && j < m_cols);
+            m_row.push_back(index_type(i));
+            m_col.push_back(index_type(j));
+            m_values.push_back(value);
+        }
+
+        size_t size() const
+        {
+            return m_values.size();
+        }
+
+        /**
+        * @brief Compresses the triplets.
+        * @tparam L Storage order of the result.
+        * @return %sparse_matrix holding the sum of the triplets.
+        *
+        * Two stable counting sorts, by inner then by outer index, order the
+        * entries in O(nnz + rows + cols); duplicates are then adjacent and
+        * are merged in one pass.
+        */
+        template <sparse_layout L = sparse_layout::csr>
+        sparse_matrix<T, L> build() const
+        {
+            const bool csr = L == sparse_layout::csr;
+            const std::vector<index_type>& outer = csr ? m_row : m_col;
+            const std::vector<index_type>& inner = csr ? m_col : m_row;
+            size_t outer_size = csr ? m_rows : m_cols;
+            size_t inner_size = csr ? m_cols : m_rows;
+            size_t count = m_values.size();
+
+            std::vector<size_t> by_inner(count);
+            counting_sort(inner, inner_size, nullptr, by_inner);
+            std::vector<size_t> order(count);
+            std::vector<size_t> offsets = counting_sort(outer, outer_size, &by_inner, order);
+
+            std::vector<index_type> indices;
+            std::vector<T> values;
+            indices.reserve(count);
+            values.reserve(count);
+            std::vector<size_t> merged(outer_size + 1, 0);
+            for (size_t o = 0; o < outer_size; ++o) {
+                for (size_t p = offsets[o]; p < offsets[o + 1]; ++p) {
+                    size_t t = order[p];
+                    if (indices.size() > merged[o] && indices.back() == inner[t]) {
+                        values.back() = values.back() + m_values[t];
+                    } else {
+                        indices.push_back(inner[t]);
+                        values.push_back(m_values[t]);
+                    }
+                }
+                merged[o + 1] = indices.size();
+            }
+            return sparse_matrix<T, L>(m_rows, m_cols, std::move(merged), std::move(indices), std::move(values));
+        }
+
+    private:
+        /**
+        * @brief Stable counting sort of triplet numbers by a key.
+        * @param key Key of each triplet.
+        * @param range Number of distinct keys.
+        * @param input Triplet numbers in their current order, or nullptr for 0, 1, 2...
+        * @param output Receives the triplet numbers sorted by key.
+        * @return Offset of each key in output, plus a final end offset.
+        */
+        static std::vector<size_t> counting_sort(const std::vector<index_type>& key, size_t range,
+                                                 const std::vector<size_t>* input, std::vector<size_t>& output)
+        {
+            std::vector<size_t> offsets(range + 1, 0);
+            for (index_type k : key) {
+                ++offsets[k + 1];
+            }
+            for (size_t i = 0; i < range; ++i) {
+                offsets[i + 1] += offsets[i];
+            }
+            std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+            for (size_t p = 0; p < key.size(); ++p) {
+                size_t t = input ? (*input)[p] : p;
+                output[next[key[t]]++] = t;
+            }
+            return offsets;
+        }
+
+        size_t m_rows, m_cols;
+        std::vector<index_type> m_row, m_col;
+        std::vector<T> m_values;
+    };
+
+    namespace detail {
+        /**
+        * @brief Multiplies compressed storage by a vector, y = A x.
+        * @param gather true to form one dot product per outer index (CSR
+        *               times x, or CSC transposed times x); false to scatter
+        *               each outer slice into y.
+        */
+        template <typename T, typename I>
+        void compressed_mv(size_t outer_size, const size_t* off, const I* idx, const T* val,
+                           const T* x, T* y, size_t y_size, bool gather)
+        {
+            if (gather) {
+                for (size_t i = 0; i < outer_size; ++i) {
+                    T acc = 0;
+                    for (size_t p = off[i]; p < off[i + 1]; ++p) {
+                        acc += val[p] * x[idx[p]];
+                    }
+                    y[i] = acc;
+                }
+            } else {
+                std::fill_n(y, y_size, T(0));
+                for (size_t j = 0; j < outer_size; ++j) {
+                    T xj = x[j];
+                    for (size_t p = off[j]; p < off[j + 1]; ++p) {
+                        y[idx[p]] += val[p] * xj;
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+    * @brief Sparse %matrix-vector product y = A x.
+    * @param mat Sparse @a m*n %matrix A.
+    * @param x Vector of @a n elements (an @a n*1 %dynmatrix).
+    * @param y Vector to write results, resized to @a m*1. Must not be x.
+    *
+    * CSR computes one dot product per row; CSC scatters one column at a time.
+    */
+    template <typename T, sparse_layout L>
+    void spmv(const sparse_matrix<T, L>& mat, const dynmatrix<T>& x, dynmatrix<T>& y)
+    {
+        assert(x.size() == mat.cols() && &x != &y);
+        y.resize(mat.rows(), 1);
+        detail::compressed_mv(mat.outer_size(), mat.offsets(), mat.indices(), mat.values(),
+                              x.data(), y.data(), y.size(), L == sparse_layout::csr);
+    }
+
+    /**
+    * @brief Transposed sparse %matrix-vector product y = A^T x.
+    * @param mat Sparse @a m*n %matrix A.
+    * @param x Vector of @a m elements.
+    * @param y Vector to write results, resized to @a n*1. Must not be x.
+    *
+    * Walks the same storage as spmv without forming A^T: CSR scatters one
+    * row at a time, CSC computes one dot product per column.
+    */
+    template <typename T, sparse_layout L>
+    void spmv_transpose(const sparse_matrix<T, L>& mat, const dynmatrix<T>& x, dynmatrix<T>& y)
+    {
+        assert(x.size() == mat.rows() && &x != &y);
+        y.resize(mat.cols(), 1);
+        detail::compressed_mv(mat.outer_size(), mat.offsets(), mat.indices(), mat.values(),
+                              x.data(), y.data(), y.size(), L == sparse_layout::csc);
+    }
+}
+
+#endif // __SPARSE_HH__
@@ -0,0 +1,336 @@
+#ifndef __SYMMATRIX_HH__
+#define __SYMMATRIX_HH__
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+
+#include "gabp/kernels.hh"
+#include "gabp/matrix.hh"
+
+namespace gmat {
+    /**
+    * @brief Symmetric @a n*n %matrix storing only its upper triangle, packed row by row.
+    * @tparam T Type of elements.
+    * @tparam n Order of the %matrix.
+    *
+    * Holds n(n+1)/2 elements instead of n*n, which for the 6*6 blocks of
+    * pose graphs is 21 instead of 36. Element i,j and element j,i are the
+    * same stored element; row i of the triangle starts at
+    * detail::packed_offset(n, i).
+    *
+    * Like %symmetric_view, a %symmatrix is defined by its upper triangle:
+    * constructing or assigning one from another %matrix reads the upper
+    * triangle of the source, and set(i, j) writes the one element shared
+    * by i,j and j,i. The entrywise %gmat algorithms see upper_stored and
+    * write only the upper triangle, so each stored element is updated
+    * exactly once. cholesky(), cholesky_solve(), symv() and syrk() have
+    * overloads that work directly on the packed form.
+    */
+    template <typename T, size_t n>
+    class symmatrix : public static_matrix<symmatrix<T, n>, T, n, n> {
+    public:
+        /**
+        * @brief Number of stored elements.
+        */
+        static constexpr size_t packed_size = n * (n + 1) / 2;
+
+        /**
+        * @brief Marks the type for detail::stores_upper.
+        */
+        static constexpr bool upper_stored = true;
+
+        /**
+        * @brief Creates a %symmatrix object.
+        * @warning Not necessarily zero-valued.
+        */
+        symmatrix() { }
+
+        /**
+        * @brief Creates a %symmatrix object with copies of an exemplar element.
+        * @param ex Exemplar element.
+        */
+        symmatrix(T ex)
+        {
+            std::fill_n(m_elements, packed_size, ex);
+        }
+
+        /**
+        * @brief Creates a %symmatrix object from the upper triangle of any %matrix or expression.
+        * @param expr %matrix or lazy expression of identical element type and order.
+        */
+        template <typename E>
+        symmatrix(const static_matrix<E, T, n, n>& expr)
+        {
+            assign_upper(expr.derived());
+        }
+
+        /**
+        * @brief Evaluates the upper triangle of a %matrix or expression into this %symmatrix.
+        * @param expr %matrix or lazy expression of identical element type and order.
+        * @return Reference to this %symmatrix.
+        *
+        * Only the upper triangle of the expression is evaluated. If it reads
+        * from this %symmatrix, it is first evaluated into a temporary.
+        */
+        template <typename E>
+        symmatrix& operator=(const static_matrix<E, T, n, n>& expr)
+        {
+            const E& e = expr.derived();
+            if (e.aliases(m_elements, m_elements + packed_size)) {
+                symmatrix tmp(e);
+                return *this = tmp;
+            }
+            assign_upper(e);
+            return *this;
+        }
+
+        /**
+        * @brief Gets the value of the element at coordinate i,j.
+        * @param i Row coordinate.
+        * @param j Column coordinate.
+        * @return Value at i,j, which is also the value at j,i.
+        *
+        * @pre i < n
+        * @pre j < n
+        */
+        T get(size_t i, size_t j) const
+        {
+            return i <= j ? m_elements[detail::packed_offset(n, i) + j - i]
+                          : m_elements[detail::packed_offset(n, j) + i - j];
+        }
+
+        /**
+        * @brief Sets the value of the element at coordinate i,j.
+        * @param i Row coordinate.
+        * @param j Column coordinate.
+        * @param value Value to be set.
+        * @return New value at i,j.
+        *
+        * Sets element j,i as well, since both are the same stored element.
+        *
+        * @pre i < n
+        * @pre j < n
+        */
+        T set(size_t i, size_t j, T value)
+        {
+            return i <= j ? m_elements[detail::packed_offset(n, i) + j - i] = value
+                          : m_elements[detail::packed_offset(n, j) + i - j] = value;
+        }
+
+        /**
+        * @brief Raw pointer to the packed upper triangle.
+        * @return Pointer to element 0,0.
+        */
+        T* data()
+        {
+            return m_elements;
+        }
+
+        const T* data() const
+        {
+            return m_elements;
+        }
+
+        bool aliases(const void* lo, const void* hi) const
+        {
+            return lo < (const void*) (m_elements + packed_size) && (const void*) m_elements < hi;
+        }
+
+    private:
+        template <typename E>
+        void assign_upper(const E& e)
+        {
+            T* row = m_elements;
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t j = i; j < n; ++j) {
+                    *row++ = e.get(i, j);
+                }
+            }
+        }
+
+        /**
+        * @brief Upper triangle of the %matrix, packed row by row.
+        */
+        T m_elements[packed_size];
+    };
+
+    /**
+    * @brief In-place Cholesky factorization S = U^T U of a packed symmetric positive definite %matrix.
+    * @tparam T Floating point type of elements.
+    * @tparam n Order of the %matrix.
+    * @param mat %symmatrix to factor, overwritten with U.
+    * @return true if mat is not positive definite, in which case its contents are unspecified.
+    *         false on success.
+    *
+    * U^T is the factor L = U^T of the dense cholesky(). The trailing
+    * updates run along the packed rows (see detail::packed_cholesky_factor).
+    */
+    template <typename T, size_t n>
+    bool cholesky(symmatrix<T, n>& mat)
+    {
+        static_assert(std::is_floating_point<T>::value, "cholesky requires a floating point element type");
+        if constexpr (n <= detail::unroll_limit) {
+            return detail::packed_cholesky_factor<n>(mat.data());
+        } else {
+            return detail::packed_cholesky_factor(n, mat.data());
+        }
+    }
+
+    namespace detail {
+        /**
+        * @brief Runs a packed triangular solve on rhs, through a temporary if its rows are not contiguous.
+        */
+        template <typename B, typename T, size_t n, size_t k, typename F>
+        void packed_solve(static_matrix<B, T, n, k>& rhs, F&& solve)
+        {
+            B& b = rhs.derived();
+            if constexpr (has_storage<B>::value) {
+                if (b.col_stride() == 1) {
+                    solve(b.data(), b.row_stride());
+                    return;
+                }
+            }
+            basematrix<T, n, k> tmp(b);
+            solve(tmp.data(), k);
+            assign(rhs, tmp);
+        }
+    }
+
+    /**
+    * @brief Solves U^T Y = B in place given the factor U from cholesky().
+    * @param chol Factor U written by cholesky.
+    * @param rhs @a n*k right-hand sides, overwritten with Y.
+    *
+    * The first half of cholesky_solve(). With S = U^T U, Y^T Y = B^T S^-1 B,
+    * which syrk() forms without touching S^-1.
+    */
+    template <typename B, typename T, size_t n, size_t k>
+    void cholesky_forward(const symmatrix<T, n>& chol, static_matrix<B, T, n, k>& rhs)
+    {
+        detail::packed_solve(rhs, [&](T* b, size_t rsb) {
+            if constexpr (n <= detail::unroll_limit) {
+                detail::packed_forward_solve<n, k>(chol.data(), b, rsb);
+            } else {
+                detail::packed_forward_solve(n, chol.data(), b, rsb, k);
+            }
+        });
+    }
+
+    /**
+    * @brief Solves S X = B in place given the factor U from cholesky().
+    * @param chol Factor U written by cholesky.
+    * @param rhs @a n*k right-hand sides, overwritten with X.
+    */
+    template <typename B, typename T, size_t n, size_t k>
+    void cholesky_solve(const symmatrix<T, n>& chol, static_matrix<B, T, n, k>& rhs)
+    {
+        detail::packed_solve(rhs, [&](T* b, size_t rsb) {
+            if constexpr (n <= detail::unroll_limit) {
+                detail::packed_forward_solve<n, k>(chol.data(), b, rsb);
+                detail::packed_backward_solve<n, k>(chol.data(), b, rsb);
+            } else {
+                detail::packed_forward_solve(n, chol.data(), b, rsb, k);
+                detail::packed_backward_solve(n, chol.data(), b, rsb, k);
+            }
+        });
+    }
+
+    /**
+    * @brief Calculates y = alpha * S x + beta * y for a packed symmetric S.
+    * @param alpha Scale of the product.
+    * @param mat %symmatrix S.
+    * @param x Reference to @a n*1 %matrix to multiply.
+    * @param beta Scale of the previous contents of y. If zero, y is not read.
+    * @param y Reference to @a n*1 %matrix to update.
+    *
+    * Runs detail::packed_symv, reading each stored element once. Operands
+    * that are not contiguous, or that overlap, are copied to the stack.
+    */
+    template <typename X, typename Y, typename T, size_t n>
+    void symv(typename symmatrix<T, n>::value_type alpha, const symmatrix<T, n>& mat, const static_matrix<X, T, n, 1>& x,
+              typename symmatrix<T, n>::value_type beta, static_matrix<Y, T, n, 1>& y)
+    {
+        const X& a = x.derived();
+        Y& c = y.derived();
+        basematrix<T, n, 1> xv, yv;
+        T* yp = yv.data();
+        bool direct = false;
+        if constexpr (detail::has_storage<Y>::value) {
+            if (c.row_stride() == 1) {
+                yp = c.data();
+                direct = true;
+            }
+        }
+        if (!direct && beta != T(0)) {
+            yv = c;
+        }
+        const T* xp = xv.data();
+        bool copy = true;
+        if constexpr (detail::has_storage<X>::value) {
+            if (a.row_stride() == 1 && !a.aliases(yp, yp + n)) {
+                xp = a.data();
+                copy = false;
+            }
+        }
+        if (copy) {
+            xv = a;
+        }
+        if constexpr (n <= detail::unroll_limit) {
+            detail::packed_symv<n>(alpha, mat.data(), xp, beta, yp);
+        } else {
+            detail::packed_symv(n, alpha, mat.data(), xp, beta, yp);
+        }
+        if (!direct) {
+            assign(y, yv);
+        }
+    }
+
+    /**
+    * @brief Symmetric rank-k update C = alpha * A^T A + beta * C on a packed C.
+    * @tparam k,n A is @a k*n and C is @a n*n.
+    * @param alpha Scale of the product.
+    * @param a Reference to %matrix A.
+    * @param beta Scale of the previous contents of c. If zero, c is not read.
+    * @param c %symmatrix to update.
+    *
+    * Only the stored triangle is computed. If A has storage with
+    * contiguous rows, the update runs on the vectorized
+    * detail::packed_syrk; otherwise each element is a dot product of two
+    * columns of A. Pass transpose(a) for C = alpha * A A^T + beta * C.
+    */
+    template <typename A, typename T, size_t k, size_t n>
+    void syrk(typename symmatrix<T, n>::value_type alpha, const static_matrix<A, T, k, n>& a,
+              typename symmatrix<T, n>::value_type beta, symmatrix<T, n>& c)
+    {
+        const A& x = a.derived();
+        if (x.aliases(c.data(), c.data() + symmatrix<T, n>::packed_size)) {
+            basematrix<T, k, n> tmp(x);
+            syrk(alpha, tmp, beta, c);
+            return;
+        }
+        if constexpr (detail::has_storage<A>::value) {
+            if (x.col_stride() == 1) {
+                if constexpr (n <= detail::unroll_limit) {
+                    detail::packed_syrk<n, k>(alpha, x.data(), x.row_stride(), beta, c.data());
+                } else {
+                    detail::packed_syrk(n, k, alpha, x.data(), x.row_stride(), beta, c.data());
+                }
+                return;
+            }
+        }
+        T* ci = c.data();
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = i; j < n; ++j) {
+                T acc = 0;
+                for (size_t p = 0; p < k; ++p) {
+                    acc += x.get(p, i) * x.get(p, j);
+                }
+                *ci = beta == T(0) ? alpha * acc : alpha * acc + beta * *ci;
+                ++ci;
+            }
+        }
+    }
+}
+
+#endif // __SYMMATRIX_HH__
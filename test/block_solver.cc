@@ -0,0 +1,71 @@
+#include "catch.hh"
+
+#include "gabp/block_solver.hh"
+#include "problems.hh"
+
+template <size_t d>
+static void check_block_solver(size_t w, size_t h)
+{
+    auto a = block_grid<d>(w, h);
+    size_t n = w * h * d;
+    auto b = rhs(n);
+    gabp::options<double> opts;
+    opts.tolerance = 1e-11;
+    opts.max_iterations = 500;
+    gabp::block_solver<double, d> s(a, opts);
+    REQUIRE_FALSE( s.solve(b) );
+    REQUIRE( s.updates() == s.iterations() * (a.nnz() - w * h) );
+
+    auto x = direct_solve(expand(a), b);
+    for (size_t i = 0; i < n; ++i) {
+        REQUIRE( s.mean()[i] == Approx(x[i]).margin(1e-9) );
+    }
+}
+
+TEST_CASE( "block gabp", "[solver]" ) {
+    SECTION( "2x2 blocks" ) {
+        check_block_solver<2>(1, 10);
+        check_block_solver<2>(6, 5);
+    }
+
+    SECTION( "3x3 blocks" ) {
+        check_block_solver<3>(1, 10);
+        check_block_solver<3>(5, 4);
+    }
+
+    SECTION( "6x6 blocks" ) {
+        check_block_solver<6>(1, 8);
+        check_block_solver<6>(4, 3);
+    }
+
+    SECTION( "exact marginals on a tree" ) {
+        auto a = block_grid<3>(1, 7);
+        gabp::block_solver<double, 3> s(a);
+        REQUIRE_FALSE( s.solve(rhs(21)) );
+        gmat::dynmatrix<double> cov;
+        REQUIRE_FALSE( gmat::inverse(densify(expand(a)), cov) );
+        for (size_t i = 0; i < 7; ++i) {
+            gmat::basematrix<double, 3, 3> marginal;
+            REQUIRE_FALSE( gmat::inverse(s.precision()[i], marginal) );
+            for (size_t r = 0; r < 3; ++r) {
+                for (size_t k = 0; k < 3; ++k) {
+                    REQUIRE( marginal.get(r, k) == Approx(cov.get(i * 3 + r, i * 3 + k)).margin(1e-12) );
+                }
+            }
+        }
+    }
+
+    SECTION( "1x1 blocks match the scalar solver" ) {
+        auto a = block_grid<1>(6, 5);
+        auto scalar = expand(a);
+        auto b = rhs(30);
+        gabp::block_solver<double, 1> s(a);
+        gabp::solver<double> ref(scalar);
+        REQUIRE_FALSE( s.solve(b) );
+        REQUIRE_FALSE( ref.solve(b) );
+        REQUIRE( s.iterations() == ref.iterations() );
+        for (size_t i = 0; i < 30; ++i) {
+            REQUIRE( s.mean()[i] == Approx(ref.mean()[i]) );
+        }
+    }
+}
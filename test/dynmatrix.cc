@@ -0,0 +1,158 @@
+#include "catch.hh"
+
+#include <cstdint>
+#include "gabp/dynmatrix.hh"
+
+TEST_CASE( "dynmatrix storage", "[dynmatrix]" ) {
+    SECTION( "small matrices stay inline" ) {
+        gmat::dynmatrix<double> a(2, 3, 1.5);
+        REQUIRE( a.rows() == 2 );
+        REQUIRE( a.cols() == 3 );
+        REQUIRE( a.get(1, 2) == 1.5 );
+        REQUIRE( (const void*) a.data() >= (const void*) &a );
+        REQUIRE( (const void*) a.data() < (const void*) (&a + 1) );
+    }
+
+    SECTION( "large matrices are aligned on the heap" ) {
+        gmat::dynmatrix<double> a(100, 100, 0.0);
+        REQUIRE( reinterpret_cast<std::uintptr_t>(a.data()) % gmat::dynmatrix<double>::alignment == 0 );
+        a.set(99, 99, 4.0);
+
+        const double* storage = a.data();
+        gmat::dynmatrix<double> b = std::move(a);
+        REQUIRE( b.data() == storage );
+        REQUIRE( b.get(99, 99) == 4.0 );
+        REQUIRE( a.size() == 0 );
+
+        gmat::dynmatrix<double> c = b.clone();
+        REQUIRE( c.data() != b.data() );
+        REQUIRE( c.get(99, 99) == 4.0 );
+    }
+
+    SECTION( "the inline buffer holds the heap capacity" ) {
+        typedef gmat::dynmatrix<double> dyn;
+        REQUIRE( sizeof(dyn) == dyn::inline_capacity * sizeof(double) + sizeof(double*) + 2 * sizeof(size_t) );
+
+        dyn a(20, 20);
+        const double* storage = a.data();
+        a.resize(10, 40);
+        REQUIRE( a.data() == storage );
+        a.resize(30, 30);
+        REQUIRE( a.data() != storage );
+        a.set(29, 29, 2.0);
+        dyn b = std::move(a);
+        b.resize(1, 900);
+        REQUIRE( b.get(0, 899) == 2.0 );
+    }
+
+    SECTION( "moving inline matrices copies the elements" ) {
+        gmat::dynmatrix<int> a(2, 2, 7);
+        gmat::dynmatrix<int> b(1, 1);
+        b = std::move(a);
+        REQUIRE( b.get(1, 1) == 7 );
+        REQUIRE( b.data() != a.data() );
+    }
+
+    SECTION( "fixed-size blocks" ) {
+        gmat::dynmatrix<int> a(4, 4, 0);
+        int id[2][2] = {
+            {1, 0},
+            {0, 1}
+        };
+        auto blk = a.block<2, 2>(1, 2);
+        blk = gmat::basematrix<int, 2, 2>((int*) id);
+        REQUIRE( a.get(1, 2) == 1 );
+        REQUIRE( a.get(2, 3) == 1 );
+        REQUIRE( a.get(1, 3) == 0 );
+
+        gmat::dynmatrix<int> copy(blk);
+        REQUIRE( copy.rows() == 2 );
+        REQUIRE( copy.get(0, 0) == 1 );
+    }
+}
+
+TEST_CASE( "dynmatrix algorithms", "[dynmatrix]" ) {
+    SECTION( "product and sum" ) {
+        gmat::dynmatrix<int> a(4, 3);
+        gmat::dynmatrix<int> b(3, 2);
+        for (size_t k = 0; k < 12; ++k) {
+            a[k] = int(k) + 1;
+        }
+        for (size_t k = 0; k < 6; ++k) {
+            b[k] = int(k) + 13;
+        }
+        gmat::dynmatrix<int> c;
+        gmat::matmul(a, b, c);
+        REQUIRE( c.rows() == 4 );
+        REQUIRE( c.cols() == 2 );
+        REQUIRE( c.get(0, 0) == 94 );
+        REQUIRE( c.get(3, 1) == 532 );
+
+        gmat::matadd(c, c, c);
+        REQUIRE( c.get(3, 1) == 1064 );
+    }
+
+    SECTION( "determinant" ) {
+        gmat::dynmatrix<int> a(5, 5);
+        int values[25] = {
+            0, 2, 1, 0, 3,
+            1, 0, 0, 2, 1,
+            3, 1, 4, 1, 5,
+            2, 7, 1, 8, 2,
+            0, 0, 1, 1, 0
+        };
+        std::copy_n(values, 25, a.data());
+        REQUIRE( gmat::det(a) == -172 );
+
+        gmat::dynmatrix<double> b(3, 3, 1.0);
+        REQUIRE( gmat::det(b) == 0.0 );
+    }
+
+    SECTION( "inverse" ) {
+        for (size_t n : { 1, 3, 4, 7, 40 }) {
+            gmat::dynmatrix<double> a(n, n);
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t j = 0; j < n; ++j) {
+                    a.set(i, j, i == j ? double(n) : double((i * 3 + j) % 5) / 5.0);
+                }
+            }
+            gmat::dynmatrix<double> inv;
+            REQUIRE_FALSE( gmat::inverse(a, inv) );
+            gmat::dynmatrix<double> id;
+            gmat::matmul(a, inv, id);
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t j = 0; j < n; ++j) {
+                    REQUIRE( id.get(i, j) == Approx(i == j ? 1.0 : 0.0).margin(1e-12) );
+                }
+            }
+        }
+
+        gmat::dynmatrix<double> singular(6, 6, 2.0);
+        gmat::dynmatrix<double> dest(1, 1, -1.0);
+        REQUIRE( gmat::inverse(singular, dest) );
+        REQUIRE( dest.rows() == 1 );
+        REQUIRE( dest.get(0, 0) == -1.0 );
+    }
+
+    SECTION( "cholesky" ) {
+        gmat::dynmatrix<double> a(3, 3);
+        double spd[9] = {
+            4, 2, 0,
+            2, 5, 1,
+            0, 1, 3
+        };
+        std::copy_n(spd, 9, a.data());
+        gmat::dynmatrix<double> l = a.clone();
+        REQUIRE_FALSE( gmat::cholesky(l) );
+        gmat::dynmatrix<double> x(3, 1);
+        x[0] = 2;
+        x[1] = 8;
+        x[2] = 4;
+        gmat::cholesky_solve(l, x);
+        gmat::dynmatrix<double> b;
+        gmat::matmul(a, x, b);
+        REQUIRE( b[0] == Approx(2.0) );
+        REQUIRE( b[1] == Approx(8.0) );
+        REQUIRE( b[2] == Approx(4.0) );
+    }
+}
@@ -0,0 +1,183 @@
+#include "catch.hh"
+
+#include "gabp/factor_graph.hh"
+#include "problems.hh"
+
+typedef gabp::factor_graph<double, 3> graph_type;
+typedef graph_type::block_type block;
+typedef graph_type::vector_type vec;
+
+static block prior(size_t v)
+{
+    block p(0.0);
+    for (size_t r = 0; r < 3; ++r) {
+        p.set(r, r, 1.0 + double((v + r) % 3));
+        for (size_t k = 0; k < r; ++k) {
+            p.set(r, k, 0.1);
+            p.set(k, r, 0.1);
+        }
+    }
+    return p;
+}
+
+static vec prior_h(size_t v)
+{
+    vec h;
+    for (size_t r = 0; r < 3; ++r) {
+        h.set(r, 0, double((v * 7 + r * 3) % 11) - 5.0);
+    }
+    return h;
+}
+
+/**
+ * @brief Adds a factor whose information blocks are those of a relative measurement.
+ *
+ * The blocks [[D, -C], [-C^T, D']] with diagonally dominant D keep the
+ * whole system walk-summable, so loopy propagation converges.
+ */
+static size_t connect(graph_type& g, size_t i, size_t j)
+{
+    block ii(0.0), jj(0.0), ij;
+    for (size_t r = 0; r < 3; ++r) {
+        ii.set(r, r, 2.0);
+        jj.set(r, r, 2.0);
+        for (size_t k = 0; k < 3; ++k) {
+            ij.set(r, k, -0.3 / double(1 + r + 2 * k) - 0.05 * double((i + j) % 3));
+        }
+    }
+    return g.add_factor(i, j, ii, ij, jj);
+}
+
+static void check_against_direct(const graph_type& g)
+{
+    auto x = direct_solve(expand(g.matrix()), g.rhs());
+    for (size_t v = 0; v < g.capacity(); ++v) {
+        if (!g.alive(v)) {
+            continue;
+        }
+        for (size_t r = 0; r < 3; ++r) {
+            REQUIRE( g.mean(v).get(r, 0) == Approx(x[v * 3 + r]).margin(1e-8) );
+        }
+    }
+}
+
+static gabp::options<double> tight()
+{
+    gabp::options<double> opts;
+    opts.tolerance = 1e-12;
+    opts.max_iterations = 500;
+    return opts;
+}
+
+TEST_CASE( "dynamic factor graph", "[solver]" ) {
+    SECTION( "chain grown one factor at a time" ) {
+        graph_type g(tight());
+        g.add_variable(prior(0), prior_h(0));
+        for (size_t v = 1; v < 12; ++v) {
+            REQUIRE( g.add_variable(prior(v), prior_h(v)) == v );
+            connect(g, v - 1, v);
+            REQUIRE_FALSE( g.propagate() );
+            check_against_direct(g);
+        }
+        REQUIRE( g.variables() == 12 );
+        REQUIRE( g.factors() == 11 );
+    }
+
+    SECTION( "loopy grid with removals" ) {
+        const size_t w = 6, h = 5;
+        graph_type g(tight());
+        for (size_t v = 0; v < w * h; ++v) {
+            g.add_variable(prior(v), prior_h(v));
+        }
+        std::vector<size_t> factors;
+        for (size_t y = 0; y < h; ++y) {
+            for (size_t x = 0; x < w; ++x) {
+                size_t i = y * w + x;
+                if (x + 1 < w) {
+                    factors.push_back(connect(g, i, i + 1));
+                }
+                if (y + 1 < h) {
+                    factors.push_back(connect(g, i, i + w));
+                }
+            }
+        }
+        REQUIRE_FALSE( g.propagate() );
+        check_against_direct(g);
+
+        g.remove_factor(factors[3]);
+        g.remove_factor(factors[17]);
+        REQUIRE_FALSE( g.propagate() );
+        check_against_direct(g);
+
+        g.remove_variable(14);
+        REQUIRE( g.variables() == w * h - 1 );
+        REQUIRE_FALSE( g.propagate() );
+        check_against_direct(g);
+
+        // The freed slots are reused.
+        REQUIRE( g.add_variable(prior(1), prior_h(1)) == 14 );
+        size_t f = connect(g, 14, 0);
+        REQUIRE( f < factors.size() );
+        connect(g, 14, 29);
+        REQUIRE_FALSE( g.propagate() );
+        check_against_direct(g);
+    }
+
+    SECTION( "changed prior" ) {
+        graph_type g(tight());
+        for (size_t v = 0; v < 8; ++v) {
+            g.add_variable(prior(v), prior_h(v));
+            if (v > 0) {
+                connect(g, v - 1, v);
+            }
+        }
+        connect(g, 0, 7);
+        REQUIRE_FALSE( g.propagate() );
+        g.set_prior(3, prior_h(40));
+        REQUIRE_FALSE( g.propagate() );
+        check_against_direct(g);
+        REQUIRE_FALSE( g.propagate() );
+        REQUIRE( g.updates() == 0 );
+    }
+
+    SECTION( "every variable removed" ) {
+        graph_type g(tight());
+        for (size_t v = 0; v < 4; ++v) {
+            g.add_variable(prior(v), prior_h(v));
+            if (v > 0) {
+                connect(g, v - 1, v);
+            }
+        }
+        REQUIRE_FALSE( g.propagate() );
+        // The removals queue their neighbours, which are then removed too.
+        for (size_t v = 0; v < 4; ++v) {
+            g.remove_variable(v);
+        }
+        REQUIRE( g.variables() == 0 );
+        REQUIRE( g.factors() == 0 );
+        REQUIRE_FALSE( g.propagate() );
+        REQUIRE( g.updates() == 0 );
+    }
+
+    SECTION( "insertion re-converges locally" ) {
+        // A long chain: a factor at one end barely moves the other end.
+        gabp::options<double> opts;
+        opts.tolerance = 1e-8;
+        graph_type g(opts);
+        const size_t n = 400;
+        for (size_t v = 0; v < n; ++v) {
+            g.add_variable(prior(v), prior_h(v));
+            if (v > 0) {
+                connect(g, v - 1, v);
+            }
+        }
+        REQUIRE_FALSE( g.propagate() );
+        size_t full = g.updates();
+
+        g.add_variable(prior(n), prior_h(n));
+        connect(g, n - 1, n);
+        REQUIRE_FALSE( g.propagate() );
+        REQUIRE( g.updates() * 10 < full );
+        check_against_direct(g);
+    }
+}
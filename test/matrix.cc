@@ -70,7 +70,7 @@ TEST_CASE( "matrix multiplication", " [matrix] ") {
 
 TEST_CASE( "matrix determinant", "[matrix]" ) {
     SECTION( "1x1 matrix" ) {
-        std::shared_ptr<gmat::matrix<int, 1, 1>> ma = std::make_shared<gmat::basematrix<int, 1, 1>>(2);
+        std::shared_ptr<gmat::matrix<int, 1, 1>> ma = std::make_shared<gmat::erased<gmat::basematrix<int, 1, 1>>>(2);
         REQUIRE( gmat::det(ma) == 2 );
     }
 
@@ -80,7 +80,698 @@ TEST_CASE( "matrix determinant", "[matrix]" ) {
             {18, 6}
         };
 
-        std::shared_ptr<gmat::matrix<int, 2, 2>> mb = std::make_shared<gmat::basematrix<int, 2, 2>>((int *)b);
+        std::shared_ptr<gmat::matrix<int, 2, 2>> mb = std::make_shared<gmat::erased<gmat::basematrix<int, 2, 2>>>((int *)b);
         REQUIRE( gmat::det(mb) == 7 * 6 - 13 * 18 );
     }
-}
\ No newline at end of file
+
+    SECTION( "3x3 matrix" ) {
+        int c[3][3] = {
+            {2, -3, 1},
+            {2, 0, -1},
+            {1, 4, 5}
+        };
+
+        gmat::basematrix<int, 3, 3> mc((int *)c);
+        REQUIRE( gmat::det(mc) == 49 );
+    }
+}
+
+TEST_CASE( "matrix static and type-erased dispatch", "[matrix]" ) {
+    int a[3][3] = {
+        {1, 2, 3},
+        {4, 5, 6},
+        {7, 8, 9}
+    };
+    auto ma = std::make_shared<gmat::basematrix<int, 3, 3>>((int*) a);
+    gmat::submatrix<int, 2, 2, 3, 3, gmat::basematrix<int, 3, 3>> sub(ma, 2, 2);
+    REQUIRE( sub.get(0, 0) == 9 );
+    REQUIRE( sub.get(0, 1) == 7 );
+    REQUIRE( sub.get(1, 0) == 3 );
+    REQUIRE( sub.get(1, 1) == 1 );
+
+    std::shared_ptr<gmat::matrix<int, 3, 3>> erased = std::make_shared<gmat::erased<gmat::basematrix<int, 3, 3>>>(*ma);
+    gmat::submatrix<int, 2, 2, 3, 3> esub(erased, 2, 2);
+    auto good = ( sub == esub );
+    REQUIRE( good );
+
+    gmat::basematrix<int, 3, 3> prod;
+    gmat::matmul(*ma, *erased, prod);
+    REQUIRE( prod.get(0, 0) == 30 );
+    REQUIRE( prod.get(2, 2) == 150 );
+
+    auto sum = *erased + *erased;
+    REQUIRE( sum.get(1, 2) == 12 );
+}
+
+TEST_CASE( "contiguous submatrix windows", "[matrix]" ) {
+    double a[4][5];
+    for (size_t i = 0; i < 4; ++i) {
+        for (size_t j = 0; j < 5; ++j) {
+            a[i][j] = 10.0 * i + j;
+        }
+    }
+    auto ma = std::make_shared<gmat::basematrix<double, 4, 5>>((double*) a);
+
+    gmat::submatrix<double, 2, 3, 4, 5, gmat::basematrix<double, 4, 5>> inner(ma, 1, 2);
+    REQUIRE( !inner.wraps() );
+    REQUIRE( inner.contiguous() );
+    REQUIRE( inner.base() == ma->data() + 7 );
+    REQUIRE( inner.row_stride() == 5 );
+    REQUIRE( inner.col_stride() == 1 );
+    REQUIRE( inner.get(1, 2) == 24.0 );
+    inner.set(0, 0, -1.0);
+    REQUIRE( ma->get(1, 2) == -1.0 );
+    auto view = inner.view();
+    REQUIRE( view.get(1, 1) == 23.0 );
+
+    // Touching the bottom right corner does not wrap.
+    gmat::submatrix<double, 2, 3, 4, 5, gmat::basematrix<double, 4, 5>> corner(ma, 2, 2);
+    REQUIRE( corner.contiguous() );
+    REQUIRE( corner.get(1, 2) == 34.0 );
+
+    gmat::submatrix<double, 2, 3, 4, 5, gmat::basematrix<double, 4, 5>> wrapped(ma, 3, 4);
+    REQUIRE( wrapped.wraps() );
+    REQUIRE( !wrapped.contiguous() );
+    REQUIRE( wrapped.base() == nullptr );
+    REQUIRE( wrapped.get(0, 0) == 34.0 );
+    REQUIRE( wrapped.get(0, 1) == 30.0 );
+    REQUIRE( wrapped.get(1, 2) == 1.0 );
+    wrapped.set(1, 1, 7.5);
+    REQUIRE( ma->get(0, 0) == 7.5 );
+
+    // Behind the type-erased interface the storage is found through storage().
+    std::shared_ptr<gmat::matrix<double, 4, 5>> erased = std::make_shared<gmat::erased<gmat::basematrix<double, 4, 5>>>(*ma);
+    gmat::submatrix<double, 2, 3, 4, 5> esub(erased, 1, 2);
+    REQUIRE( esub.contiguous() );
+    auto same = ( esub == inner );
+    REQUIRE( same );
+    esub.set(1, 0, 100.0);
+    REQUIRE( erased->get(2, 2) == 100.0 );
+
+    // A parent without addressable storage still skips the modulo.
+    auto window = std::make_shared<gmat::erased<gmat::submatrix<double, 4, 5, 4, 5, gmat::basematrix<double, 4, 5>>>>(ma, 0, 0);
+    gmat::submatrix<double, 2, 3, 4, 5, gmat::matrix<double, 4, 5>> xsub(window, 1, 2);
+    REQUIRE( !xsub.wraps() );
+    REQUIRE( !xsub.contiguous() );
+    REQUIRE( xsub.get(1, 2) == 24.0 );
+}
+
+TEST_CASE( "bulk assignment between matrices", "[matrix]" ) {
+    double a[4][5];
+    for (size_t i = 0; i < 4; ++i) {
+        for (size_t j = 0; j < 5; ++j) {
+            a[i][j] = 10.0 * i + j;
+        }
+    }
+    auto ma = std::make_shared<gmat::basematrix<double, 4, 5>>((double*) a);
+    std::shared_ptr<gmat::matrix<double, 4, 5>> erased = std::make_shared<gmat::erased<gmat::basematrix<double, 4, 5>>>(*ma);
+
+    SECTION( "wrapping submatrix into basematrix" ) {
+        gmat::submatrix<double, 3, 3, 4, 5, gmat::basematrix<double, 4, 5>> sub(ma, 2, 3);
+        gmat::submatrix<double, 3, 3, 4, 5> esub(erased, 2, 3);
+        REQUIRE( sub.wraps() );
+        gmat::basematrix<double, 3, 3> b(sub);
+        gmat::basematrix<double, 3, 3> eb(esub);
+        for (size_t i = 0; i < 3; ++i) {
+            for (size_t j = 0; j < 3; ++j) {
+                REQUIRE( b.get(i, j) == a[(i + 2) % 4][(j + 3) % 5] );
+                REQUIRE( eb.get(i, j) == b.get(i, j) );
+            }
+        }
+    }
+
+    SECTION( "into a wrapping submatrix" ) {
+        gmat::basematrix<double, 2, 3> src;
+        for (size_t i = 0; i < 2; ++i) {
+            for (size_t j = 0; j < 3; ++j) {
+                src.set(i, j, -1.0 - 3.0 * i - j);
+            }
+        }
+        gmat::submatrix<double, 2, 3, 4, 5> dest(erased, 3, 4);
+        gmat::assign(dest, src);
+        REQUIRE( erased->get(3, 4) == -1.0 );
+        REQUIRE( erased->get(3, 0) == -2.0 );
+        REQUIRE( erased->get(3, 1) == -3.0 );
+        REQUIRE( erased->get(0, 4) == -4.0 );
+        REQUIRE( erased->get(0, 1) == -6.0 );
+        REQUIRE( erased->get(1, 1) == 11.0 );
+    }
+
+    SECTION( "strided views fall back to elements" ) {
+        gmat::matrix_view<const double, 3, 2> transposed(ma->data(), 1, 5);
+        gmat::basematrix<double, 3, 2> t;
+        gmat::assign(t, transposed);
+        REQUIRE( t.get(2, 1) == 12.0 );
+        gmat::basematrix<double, 2, 3> back;
+        gmat::matrix_view<double, 3, 2> out(back.data(), 1, 3);
+        out = t;
+        REQUIRE( back.get(1, 2) == 12.0 );
+        REQUIRE( back.get(0, 1) == 1.0 );
+    }
+
+    SECTION( "overlapping windows of one parent" ) {
+        gmat::submatrix<double, 3, 4, 4, 5, gmat::basematrix<double, 4, 5>> from(ma, 0, 0);
+        gmat::submatrix<double, 3, 4, 4, 5, gmat::basematrix<double, 4, 5>> to(ma, 1, 1);
+        gmat::assign(to, from);
+        for (size_t i = 0; i < 3; ++i) {
+            for (size_t j = 0; j < 4; ++j) {
+                REQUIRE( ma->get(i + 1, j + 1) == a[i][j] );
+            }
+        }
+        REQUIRE( ma->get(0, 0) == 0.0 );
+    }
+}
+
+TEST_CASE( "matrix expressions", "[matrix]" ) {
+    int a[2][3] = {
+        {1, 2, 3},
+        {4, 5, 6}
+    };
+    int b[3][2] = {
+        {7, 8},
+        {9, 10},
+        {11, 12}
+    };
+    int c[2][2] = {
+        {1, -1},
+        {2, -2}
+    };
+    gmat::basematrix<int, 2, 3> ma((int*) a);
+    gmat::basematrix<int, 3, 2> mb((int*) b);
+    gmat::basematrix<int, 2, 2> mc((int*) c);
+
+    SECTION( "fused product and sum" ) {
+        gmat::basematrix<int, 2, 2> md = ma * mb + mc;
+        int expected[2][2] = {
+            {59, 63},
+            {141, 152}
+        };
+        REQUIRE( md == gmat::basematrix<int, 2, 2>((int*) expected) );
+        md = md - mc;
+        REQUIRE( md == ma * mb );
+    }
+
+    SECTION( "nested products" ) {
+        gmat::basematrix<int, 2, 2> md = (ma * mb) * mc;
+        gmat::basematrix<int, 2, 2> prod;
+        gmat::basematrix<int, 2, 2> expected;
+        gmat::matmul(ma, mb, prod);
+        gmat::matmul(prod, mc, expected);
+        REQUIRE( md == expected );
+    }
+
+    SECTION( "aliased assignment" ) {
+        gmat::basematrix<int, 2, 2> md = mc;
+        md = md * mc;
+        int expected[2][2] = {
+            {-1, 1},
+            {-2, 2}
+        };
+        REQUIRE( md == gmat::basematrix<int, 2, 2>((int*) expected) );
+    }
+}
+
+TEST_CASE( "in-place arithmetic", "[matrix]" ) {
+    int a[2][3] = {
+        {1, 2, 3},
+        {4, 5, 6}
+    };
+    int b[3][2] = {
+        {7, 8},
+        {9, 10},
+        {11, 12}
+    };
+    int c[2][2] = {
+        {1, -1},
+        {2, -2}
+    };
+    gmat::basematrix<int, 2, 3> ma((int*) a);
+    gmat::basematrix<int, 3, 2> mb((int*) b);
+    gmat::basematrix<int, 2, 2> mc((int*) c);
+
+    SECTION( "compound operators" ) {
+        gmat::basematrix<int, 2, 3> md = ma;
+        md += ma;
+        md *= 3;
+        md -= ma;
+        REQUIRE( md == ma + ma + ma + ma + ma );
+        gmat::axpy(-5, ma, md);
+        REQUIRE( md == gmat::basematrix<int, 2, 3>(0) );
+    }
+
+    SECTION( "accumulated products" ) {
+        gmat::basematrix<int, 2, 2> md = mc;
+        md += ma * mb;
+        REQUIRE( md == ma * mb + mc );
+        md -= ma * mb;
+        REQUIRE( md == mc );
+        gmat::gemm(2, ma, mb, -1, md);
+        int expected[2][2] = {
+            {115, 129},
+            {276, 310}
+        };
+        REQUIRE( md == gmat::basematrix<int, 2, 2>((int*) expected) );
+    }
+
+    SECTION( "aliased operands" ) {
+        gmat::basematrix<int, 2, 2> md = mc;
+        md += md * mc;
+        int expected[2][2] = {
+            {0, 0},
+            {0, 0}
+        };
+        REQUIRE( md == gmat::basematrix<int, 2, 2>((int*) expected) );
+        double e[3][4] = {
+            {1, 2, 3, 4},
+            {5, 6, 7, 8},
+            {9, 10, 11, 12}
+        };
+        gmat::matrix_view<double, 2, 3> lo(&e[0][0], 4, 1);
+        gmat::matrix_view<double, 2, 3> hi(&e[1][1], 4, 1);
+        hi += lo;
+        REQUIRE( e[1][1] == 7.0 );
+        REQUIRE( e[2][2] == 17.0 );
+        REQUIRE( e[2][3] == 19.0 );
+    }
+
+    SECTION( "vectorized accumulation" ) {
+        auto x = std::make_unique<gmat::basematrix<double, 16, 12>>();
+        auto y = std::make_unique<gmat::basematrix<double, 12, 16>>();
+        auto z = std::make_unique<gmat::basematrix<double, 16, 16>>(1.0);
+        for (size_t i = 0; i < 16; ++i) {
+            for (size_t k = 0; k < 12; ++k) {
+                x->set(i, k, double((i + 2 * k) % 5) - 2.0);
+                y->set(k, i, double((3 * i + k) % 7) / 2.0);
+            }
+        }
+        gmat::basematrix<double, 16, 16> expected = *x * *y;
+        gmat::gemm(0.5, *x, *y, 2.0, *z);
+        for (size_t i = 0; i < 16; ++i) {
+            for (size_t j = 0; j < 16; ++j) {
+                REQUIRE( z->get(i, j) == Approx(0.5 * expected.get(i, j) + 2.0) );
+            }
+        }
+    }
+}
+
+TEST_CASE( "transpose and symmetric views", "[matrix]" ) {
+    double a[3][2] = {
+        {1, 2},
+        {3, 4},
+        {5, 6}
+    };
+    double b[3][3] = {
+        {1, 2, 3},
+        {-7, 4, 5},
+        {-8, -9, 6}
+    };
+    gmat::basematrix<double, 3, 2> ma((double*) a);
+    gmat::basematrix<double, 3, 3> mb((double*) b);
+    gmat::basematrix<double, 3, 3> sym;
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            sym.set(i, j, b[std::min(i, j)][std::max(i, j)]);
+        }
+    }
+    gmat::basematrix<double, 2, 3> mat;
+    for (size_t i = 0; i < 2; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            mat.set(i, j, a[j][i]);
+        }
+    }
+
+    SECTION( "element access" ) {
+        auto t = gmat::transpose(ma);
+        REQUIRE( t == mat );
+        t.set(1, 2, 60.0);
+        REQUIRE( ma.get(2, 1) == 60.0 );
+        REQUIRE( gmat::symmetric(mb) == sym );
+
+        // Writes through a symmetric view, or into an expression, do not compile.
+        REQUIRE( gmat::detail::is_writable<decltype(t)>::value );
+        REQUIRE( !gmat::detail::is_writable<decltype(gmat::symmetric(mb))>::value );
+        REQUIRE( !gmat::detail::is_writable<decltype(ma + ma)>::value );
+    }
+
+    SECTION( "transposed products" ) {
+        gmat::basematrix<double, 2, 3> ta = gmat::transpose(ma) * mb;
+        REQUIRE( ta == mat * mb );
+        gmat::basematrix<double, 3, 3> tb = mb * gmat::transpose(mb);
+        gmat::basematrix<double, 3, 3> mbt = gmat::transpose(mb);
+        REQUIRE( tb == mb * mbt );
+        gmat::basematrix<double, 2, 2> gram(1.0);
+        gmat::gemm(2.0, gmat::transpose(ma), ma, 1.0, gram);
+        int expected[2][2] = {
+            {71, 89},
+            {89, 113}
+        };
+        for (size_t i = 0; i < 2; ++i) {
+            for (size_t j = 0; j < 2; ++j) {
+                REQUIRE( gram.get(i, j) == expected[i][j] );
+            }
+        }
+    }
+
+    SECTION( "symmetric products" ) {
+        gmat::basematrix<double, 3, 2> left = gmat::symmetric(mb) * ma;
+        REQUIRE( left == sym * ma );
+        gmat::basematrix<double, 2, 3> right = mat * gmat::symmetric(mb);
+        REQUIRE( right == mat * sym );
+        gmat::basematrix<double, 3, 3> both = gmat::symmetric(mb) * gmat::symmetric(mb);
+        REQUIRE( both == sym * sym );
+        gmat::basematrix<double, 3, 2> acc = ma;
+        acc -= gmat::symmetric(mb) * ma;
+        REQUIRE( acc == ma - sym * ma );
+    }
+
+    SECTION( "vectorized transposed products" ) {
+        auto x = std::make_unique<gmat::basematrix<float, 40, 24>>();
+        auto y = std::make_unique<gmat::basematrix<float, 40, 24>>();
+        for (size_t i = 0; i < 40; ++i) {
+            for (size_t j = 0; j < 24; ++j) {
+                x->set(i, j, float((i + 3 * j) % 7) - 3.0f);
+                y->set(i, j, float((2 * i + j) % 5) / 4.0f);
+            }
+        }
+        gmat::basematrix<float, 24, 24> xty = gmat::transpose(*x) * *y;
+        gmat::basematrix<float, 40, 40> xyt = *x * gmat::transpose(*y);
+        for (size_t i = 0; i < 40; ++i) {
+            for (size_t j = 0; j < 40; ++j) {
+                float acc = 0;
+                for (size_t k = 0; k < 24; ++k) {
+                    acc += x->get(i, k) * y->get(j, k);
+                }
+                REQUIRE( xyt.get(i, j) == Approx(acc) );
+            }
+        }
+        for (size_t i = 0; i < 24; ++i) {
+            for (size_t j = 0; j < 24; ++j) {
+                float acc = 0;
+                for (size_t k = 0; k < 40; ++k) {
+                    acc += x->get(k, i) * y->get(k, j);
+                }
+                REQUIRE( xty.get(i, j) == Approx(acc) );
+            }
+        }
+    }
+}
+
+template <typename T, size_t m, size_t n, size_t o>
+static void check_vectorized_matmul()
+{
+    auto a = std::make_unique<gmat::basematrix<T, m, n>>();
+    auto b = std::make_unique<gmat::basematrix<T, n, o>>();
+    auto c = std::make_unique<gmat::basematrix<T, m, o>>();
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t k = 0; k < n; ++k) {
+            a->set(i, k, T((i * 7 + k * 3) % 11) - T(5));
+        }
+    }
+    for (size_t k = 0; k < n; ++k) {
+        for (size_t j = 0; j < o; ++j) {
+            b->set(k, j, T((k * 5 + j) % 13) / T(4));
+        }
+    }
+    gmat::matmul(*a, *b, *c);
+    for (size_t i = 0; i < m; ++i) {
+        for (size_t j = 0; j < o; ++j) {
+            T acc = 0;
+            for (size_t k = 0; k < n; ++k) {
+                acc += a->get(i, k) * b->get(k, j);
+            }
+            REQUIRE( c->get(i, j) == Approx(acc).epsilon(1e-4) );
+        }
+    }
+}
+
+TEST_CASE( "vectorized matrix multiplication", "[matrix]" ) {
+    SECTION( "register-blocked, in cache" ) {
+        check_vectorized_matmul<double, 13, 17, 19>();
+        check_vectorized_matmul<float, 8, 8, 32>();
+    }
+
+    SECTION( "packed and tiled" ) {
+        check_vectorized_matmul<double, 70, 300, 1100>();
+        check_vectorized_matmul<float, 101, 130, 67>();
+    }
+}
+
+template <size_t n>
+static void check_inverse()
+{
+    gmat::basematrix<double, n, n> a;
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            a.set(i, j, i == j ? double(n + 1) : double((i * 3 + j * 5) % 7) / 7.0 - 0.5);
+        }
+    }
+    gmat::basematrix<double, n, n> inv;
+    REQUIRE_FALSE( gmat::inverse(a, inv) );
+    gmat::basematrix<double, n, n> id = a * inv;
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            REQUIRE( id.get(i, j) == Approx(i == j ? 1.0 : 0.0).margin(1e-12) );
+        }
+    }
+}
+
+TEST_CASE( "matrix inverse", "[matrix]" ) {
+    SECTION( "closed form" ) {
+        check_inverse<1>();
+        check_inverse<2>();
+        check_inverse<3>();
+        check_inverse<4>();
+    }
+
+    SECTION( "LU with partial pivoting" ) {
+        check_inverse<5>();
+        check_inverse<8>();
+
+        double p[5][5] = {
+            {0, 1, 0, 0, 0},
+            {0, 0, 0, 1, 0},
+            {1, 0, 0, 0, 0},
+            {0, 0, 0, 0, 2},
+            {0, 0, 4, 0, 0}
+        };
+        gmat::basematrix<double, 5, 5> mp((double*) p);
+        gmat::basematrix<double, 5, 5> inv;
+        REQUIRE_FALSE( gmat::inverse(mp, inv) );
+        REQUIRE( inv.get(1, 0) == 1.0 );
+        REQUIRE( inv.get(4, 3) == 0.5 );
+        REQUIRE( inv.get(2, 4) == 0.25 );
+    }
+
+    SECTION( "in place" ) {
+        double a[2][2] = {
+            {4, 7},
+            {2, 6}
+        };
+        gmat::basematrix<double, 2, 2> ma((double*) a);
+        REQUIRE_FALSE( gmat::inverse(ma, ma) );
+        REQUIRE( ma.get(0, 0) == Approx(0.6) );
+        REQUIRE( ma.get(0, 1) == Approx(-0.7) );
+    }
+
+    SECTION( "singular matrices leave dest unchanged" ) {
+        double s3[3][3] = {
+            {1, 2, 3},
+            {4, 5, 6},
+            {7, 8, 9}
+        };
+        gmat::basematrix<double, 3, 3> ms3((double*) s3);
+        gmat::basematrix<double, 3, 3> d3(-1.0);
+        REQUIRE( gmat::inverse(ms3, d3) );
+        REQUIRE( d3 == gmat::basematrix<double, 3, 3>(-1.0) );
+
+        gmat::basematrix<double, 6, 6> ms6(1.0);
+        gmat::basematrix<double, 6, 6> d6(-1.0);
+        REQUIRE( gmat::inverse(ms6, d6) );
+        REQUIRE( d6 == gmat::basematrix<double, 6, 6>(-1.0) );
+    }
+}
+
+TEST_CASE( "matrix determinant by factorization", "[matrix]" ) {
+    SECTION( "exact integer elimination" ) {
+        int a[5][5] = {
+            {0, 2, 1, 0, 3},
+            {1, 0, 0, 2, 1},
+            {3, 1, 4, 1, 5},
+            {2, 7, 1, 8, 2},
+            {0, 0, 1, 1, 0}
+        };
+        gmat::basematrix<int, 5, 5> ma((int*) a);
+        REQUIRE( gmat::det(ma) == -172 );
+
+        int s[4][4] = {
+            {1, 2, 3, 4},
+            {2, 4, 6, 8},
+            {0, 1, 0, 1},
+            {1, 0, 0, 1}
+        };
+        gmat::basematrix<int, 4, 4> ms((int*) s);
+        REQUIRE( gmat::det(ms) == 0 );
+    }
+
+    SECTION( "pivoted LU" ) {
+        double a[4][4] = {
+            {0, 2, 1, 0},
+            {1, 0, 0, 2},
+            {3, 1, 4, 1},
+            {2, 7, 1, 8}
+        };
+        gmat::basematrix<double, 4, 4> ma((double*) a);
+        REQUIRE( gmat::det(ma) == Approx(-3.0) );
+
+        int sign;
+        REQUIRE( gmat::logdet(ma, sign) == Approx(std::log(3.0)) );
+        REQUIRE( sign == -1 );
+    }
+
+    SECTION( "log-determinant beyond the range of T" ) {
+        gmat::basematrix<double, 6, 6> big(0.0);
+        for (size_t i = 0; i < 6; ++i) {
+            big.set(i, i, 1e300);
+        }
+        int sign;
+        REQUIRE( gmat::logdet(big, sign) == Approx(6 * 300 * std::log(10.0)) );
+        REQUIRE( sign == 1 );
+
+        gmat::basematrix<double, 6, 6> singular(1.0);
+        REQUIRE( gmat::logdet(singular, sign) == -std::numeric_limits<double>::infinity() );
+        REQUIRE( sign == 0 );
+        REQUIRE( gmat::det(singular) == 0.0 );
+    }
+}
+
+template <size_t n>
+static void check_cholesky()
+{
+    // A = M M^T + n I is symmetric positive definite.
+    gmat::basematrix<double, n, n> mm;
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            mm.set(i, j, double((i * 5 + j * 3) % 7) / 7.0 - 0.4);
+        }
+    }
+    gmat::basematrix<double, n, n> a;
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            double acc = i == j ? double(n) : 0.0;
+            for (size_t k = 0; k < n; ++k) {
+                acc += mm.get(i, k) * mm.get(j, k);
+            }
+            a.set(i, j, acc);
+        }
+    }
+
+    gmat::basematrix<double, n, n> chol(a);
+    REQUIRE_FALSE( gmat::cholesky(chol) );
+
+    gmat::basematrix<double, n, 2> b;
+    for (size_t i = 0; i < n; ++i) {
+        b.set(i, 0, double(i) + 1.0);
+        b.set(i, 1, double(n) - 2.0 * double(i));
+    }
+    gmat::basematrix<double, n, 2> x(b);
+    gmat::cholesky_solve(chol, x);
+    gmat::basematrix<double, n, 2> ax = a * x;
+    for (size_t i = 0; i < n; ++i) {
+        REQUIRE( ax.get(i, 0) == Approx(b.get(i, 0)).margin(1e-12) );
+        REQUIRE( ax.get(i, 1) == Approx(b.get(i, 1)).margin(1e-12) );
+    }
+
+    gmat::basematrix<double, n, n> inv;
+    gmat::cholesky_inverse(chol, inv);
+    gmat::basematrix<double, n, n> id = a * inv;
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            REQUIRE( id.get(i, j) == Approx(i == j ? 1.0 : 0.0).margin(1e-12) );
+        }
+    }
+}
+
+TEST_CASE( "matrix cholesky factorization", "[matrix]" ) {
+    SECTION( "unrolled" ) {
+        check_cholesky<1>();
+        check_cholesky<2>();
+        check_cholesky<3>();
+        check_cholesky<6>();
+    }
+
+    SECTION( "looped" ) {
+        check_cholesky<9>();
+    }
+
+    SECTION( "not positive definite" ) {
+        double a[2][2] = {
+            {1, 2},
+            {2, 1}
+        };
+        gmat::basematrix<double, 2, 2> ma((double*) a);
+        REQUIRE( gmat::cholesky(ma) );
+
+        gmat::basematrix<double, 8, 8> mb(1.0);
+        REQUIRE( gmat::cholesky(mb) );
+    }
+}
+
+TEST_CASE( "matrix views over external memory", "[matrix]" ) {
+    double storage[4][5] = {
+        {1, 2, 3, 4, 5},
+        {6, 7, 8, 9, 10},
+        {11, 12, 13, 14, 15},
+        {16, 17, 18, 19, 20}
+    };
+
+    SECTION( "strided windows" ) {
+        gmat::matrix_view<double, 2, 2> block(&storage[1][1], 5);
+        REQUIRE( block.get(0, 0) == 7 );
+        REQUIRE( block.get(1, 1) == 13 );
+
+        gmat::matrix_view<const double, 2, 4> transposed(&storage[0][0], 1, 5);
+        REQUIRE( transposed.get(1, 2) == 12 );
+        REQUIRE( transposed.get(0, 3) == 16 );
+
+        block.set(0, 0, -1);
+        REQUIRE( storage[1][1] == -1 );
+    }
+
+    SECTION( "algorithms write through views" ) {
+        double id[2][2] = {
+            {1, 0},
+            {0, 1}
+        };
+        gmat::matrix_view<double, 2, 2> block(&storage[2][3], 5);
+        gmat::matrix_view<const double, 2, 2> identity(&id[0][0]);
+        gmat::basematrix<double, 2, 2> copy = block * identity;
+        REQUIRE( copy.get(1, 1) == 20 );
+
+        gmat::matrix_view<double, 2, 2> dest(&storage[0][0], 5);
+        dest = block + identity;
+        REQUIRE( storage[0][0] == 15 );
+        REQUIRE( storage[1][1] == 21 );
+        REQUIRE( storage[0][2] == 3 );
+    }
+
+    SECTION( "overlapping assignment" ) {
+        gmat::matrix_view<double, 2, 2> top(&storage[0][0], 5);
+        gmat::matrix_view<double, 2, 2> shifted(&storage[0][1], 5);
+        shifted = top * top;
+        REQUIRE( storage[0][1] == 1 * 1 + 2 * 6 );
+        REQUIRE( storage[1][2] == 6 * 2 + 7 * 7 );
+    }
+
+    SECTION( "factorizations in place" ) {
+        double spd[9] = {
+            4, 2, 0,
+            2, 5, 1,
+            0, 1, 3
+        };
+        gmat::matrix_view<double, 3, 3> a(spd);
+        REQUIRE_FALSE( gmat::cholesky(a) );
+        REQUIRE( spd[0] == Approx(2.0) );
+        REQUIRE( spd[3] == Approx(1.0) );
+        REQUIRE( spd[4] == Approx(2.0) );
+    }
+}
@@ -0,0 +1,95 @@
+#include "catch.hh"
+
+#include "gabp/pcg.hh"
+#include "problems.hh"
+
+template <typename P>
+static size_t check_pcg(const gmat::sparse_matrix<double>& a, const gmat::dynmatrix<double>& b, P& precond)
+{
+    gabp::options<double> opts;
+    opts.tolerance = 1e-10;
+    opts.max_iterations = 1000;
+    gabp::pcg<double> cg(a, opts);
+    REQUIRE_FALSE( cg.solve(b, precond) );
+    REQUIRE( cg.residual() <= 1e-10 );
+    REQUIRE( cg.seconds() >= 0.0 );
+    auto x = direct_solve(a, b);
+    for (size_t i = 0; i < a.rows(); ++i) {
+        REQUIRE( cg.solution()[i] == Approx(x[i]).margin(1e-7) );
+    }
+    return cg.iterations();
+}
+
+TEST_CASE( "preconditioned conjugate gradients", "[solver]" ) {
+    SECTION( "walk-summable grid" ) {
+        auto a = poisson_2d(20, 16, 0.01);
+        auto b = rhs(320);
+        gabp::identity_preconditioner<double> none;
+        gabp::jacobi_preconditioner<double> jacobi(a);
+        gabp::block_jacobi_preconditioner<double> block(a, 20);
+        gabp::gabp_preconditioner<double> bp(a, 2);
+        size_t plain = check_pcg(a, b, none);
+        size_t diag = check_pcg(a, b, jacobi);
+        size_t rows = check_pcg(a, b, block);
+        size_t sweeps = check_pcg(a, b, bp);
+        REQUIRE( rows < diag );
+        REQUIRE( sweeps < diag );
+        REQUIRE( diag <= plain );
+    }
+
+    SECTION( "not walk-summable" ) {
+        // Unit diagonal and 0.3 between every pair of 6 variables:
+        // positive definite, but the absolute couplings have spectral
+        // radius 1.5, and plain GaBP does not converge.
+        const size_t n = 6;
+        gmat::coo_builder<double> coo(n, n);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                coo.add(i, j, i == j ? 1.0 : 0.3);
+            }
+        }
+        auto a = coo.build();
+        auto b = rhs(n);
+
+        gabp::options<double> opts;
+        opts.max_iterations = 200;
+        gabp::solver<double> s(a, opts);
+        REQUIRE( s.solve(b) );
+
+        gabp::gabp_preconditioner<double> bp(a, 2, opts);
+        check_pcg(a, b, bp);
+        gabp::jacobi_preconditioner<double> jacobi(a);
+        check_pcg(a, b, jacobi);
+    }
+
+    SECTION( "indefinite diagonal block" ) {
+        // The first block [[1, 2], [2, 1]] has eigenvalues 3 and -1.
+        gmat::coo_builder<double> coo(4, 4);
+        coo.add(0, 0, 1.0);
+        coo.add(0, 1, 2.0);
+        coo.add(1, 0, 2.0);
+        coo.add(1, 1, 1.0);
+        coo.add(2, 2, 4.0);
+        coo.add(2, 3, 1.0);
+        coo.add(3, 2, 1.0);
+        coo.add(3, 3, 4.0);
+        auto a = coo.build();
+        gabp::block_jacobi_preconditioner<double> block(a, 2);
+        REQUIRE( block.fallbacks() == 1 );
+
+        gmat::dynmatrix<double> r(4, 1, 1.0), z(4, 1, 0.0);
+        block.apply(r, z);
+        REQUIRE( z[0] == Approx(1.0) );
+        REQUIRE( z[1] == Approx(1.0) );
+        REQUIRE( z[2] == Approx(0.2) );
+        REQUIRE( z[3] == Approx(0.2) );
+    }
+
+    SECTION( "zero right-hand side" ) {
+        auto a = poisson_2d(4, 4);
+        gabp::pcg<double> cg(a);
+        gabp::jacobi_preconditioner<double> jacobi(a);
+        REQUIRE_FALSE( cg.solve(gmat::dynmatrix<double>(16, 1, 0.0), jacobi) );
+        REQUIRE( cg.iterations() == 0 );
+    }
+}
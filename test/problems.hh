@@ -0,0 +1,167 @@
+#ifndef __PROBLEMS_HH__
+#define __PROBLEMS_HH__
+
+#include "gabp/dynmatrix.hh"
+#include "gabp/matrix.hh"
+#include "gabp/sparse.hh"
+
+/*
+ * Small sparse systems shared by the solver tests.
+ */
+
+/**
+ * @brief 5-point Laplacian of a w*h grid plus shift on the diagonal.
+ */
+inline gmat::sparse_matrix<double> poisson_2d(size_t w, size_t h, double shift = 0.5)
+{
+    gmat::coo_builder<double> coo(w * h, w * h);
+    for (size_t y = 0; y < h; ++y) {
+        for (size_t x = 0; x < w; ++x) {
+            size_t i = y * w + x;
+            coo.add(i, i, 4.0 + shift);
+            if (x > 0) {
+                coo.add(i, i - 1, -1.0);
+            }
+            if (x + 1 < w) {
+                coo.add(i, i + 1, -1.0);
+            }
+            if (y > 0) {
+                coo.add(i, i - w, -1.0);
+            }
+            if (y + 1 < h) {
+                coo.add(i, i + w, -1.0);
+            }
+        }
+    }
+    return coo.build();
+}
+
+/**
+ * @brief Tridiagonal system of a chain, a tree on which GaBP is exact.
+ */
+inline gmat::sparse_matrix<double> chain(size_t n)
+{
+    gmat::coo_builder<double> coo(n, n);
+    for (size_t i = 0; i < n; ++i) {
+        coo.add(i, i, 3.0 + double(i % 3));
+        if (i + 1 < n) {
+            coo.add(i, i + 1, -1.0 - 0.1 * double(i % 4));
+            coo.add(i + 1, i, -1.0 - 0.1 * double(i % 4));
+        }
+    }
+    return coo.build();
+}
+
+/**
+ * @brief Deterministic right-hand side.
+ */
+inline gmat::dynmatrix<double> rhs(size_t n, size_t seed = 1)
+{
+    gmat::dynmatrix<double> b(n, 1);
+    for (size_t i = 0; i < n; ++i) {
+        b[i] = double((i * 7 + seed * 13) % 11) - 5.0;
+    }
+    return b;
+}
+
+/**
+ * @brief Dense copy of a sparse matrix.
+ */
+inline gmat::dynmatrix<double> densify(const gmat::sparse_matrix<double>& a)
+{
+    gmat::dynmatrix<double> d(a.rows(), a.cols(), 0.0);
+    for (size_t i = 0; i < a.rows(); ++i) {
+        for (auto e : a.neighbors(i)) {
+            d.set(i, e.index, e.value);
+        }
+    }
+    return d;
+}
+
+/**
+ * @brief Reference solution by dense Cholesky.
+ */
+inline gmat::dynmatrix<double> direct_solve(const gmat::sparse_matrix<double>& a, const gmat::dynmatrix<double>& b)
+{
+    gmat::dynmatrix<double> l = densify(a);
+    gmat::cholesky(l);
+    gmat::dynmatrix<double> x = b.clone();
+    gmat::cholesky_solve(l, x);
+    return x;
+}
+
+/**
+ * @brief Block system of a w*h grid of d-dimensional variables.
+ *
+ * Diagonal blocks are diagonally dominant and symmetric; the coupling
+ * between neighbors is a non-symmetric d*d block and its transpose. A
+ * 1-wide grid is a chain, a tree.
+ */
+template <size_t d>
+gmat::sparse_matrix<gmat::basematrix<double, d, d>> block_grid(size_t w, size_t h)
+{
+    typedef gmat::basematrix<double, d, d> block;
+    gmat::coo_builder<block> coo(w * h, w * h);
+    auto coupling = [](size_t i, size_t j) {
+        block c;
+        for (size_t r = 0; r < d; ++r) {
+            for (size_t k = 0; k < d; ++k) {
+                c.set(r, k, -0.3 / double(1 + r + 2 * k) - 0.05 * double((i + j) % 3));
+            }
+        }
+        return c;
+    };
+    auto add_edge = [&](size_t i, size_t j) {
+        block c = coupling(i, j);
+        block t;
+        for (size_t r = 0; r < d; ++r) {
+            for (size_t k = 0; k < d; ++k) {
+                t.set(k, r, c.get(r, k));
+            }
+        }
+        coo.add(i, j, c);
+        coo.add(j, i, t);
+    };
+    for (size_t y = 0; y < h; ++y) {
+        for (size_t x = 0; x < w; ++x) {
+            size_t i = y * w + x;
+            block diag(0.0);
+            for (size_t r = 0; r < d; ++r) {
+                diag.set(r, r, 2.0 + 2.0 * double(d) + double((i + r) % 3));
+                for (size_t k = 0; k < r; ++k) {
+                    diag.set(r, k, 0.2);
+                    diag.set(k, r, 0.2);
+                }
+            }
+            coo.add(i, i, diag);
+            if (x + 1 < w) {
+                add_edge(i, i + 1);
+            }
+            if (y + 1 < h) {
+                add_edge(i, i + w);
+            }
+        }
+    }
+    return coo.build();
+}
+
+/**
+ * @brief Scalar copy of a block sparse matrix.
+ */
+template <size_t d>
+gmat::sparse_matrix<double> expand(const gmat::sparse_matrix<gmat::basematrix<double, d, d>>& a)
+{
+    gmat::coo_builder<double> coo(a.rows() * d, a.cols() * d);
+    for (size_t i = 0; i < a.rows(); ++i) {
+        for (auto e : a.neighbors(i)) {
+            for (size_t r = 0; r < d; ++r) {
+                for (size_t k = 0; k < d; ++k) {
+                    coo.add(i * d + r, e.index * d + k, e.value.get(r, k));
+                }
+            }
+        }
+    }
+    return coo.build();
+}
+
+#endif // __PROBLEMS_HH__
@@ -0,0 +1,131 @@
+#include "catch.hh"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "gabp/reorder.hh"
+#include "problems.hh"
+
+static std::vector<size_t> shuffled(size_t n)
+{
+    std::vector<size_t> order(n);
+    for (size_t k = 0; k < n; ++k) {
+        order[k] = k;
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(42));
+    return order;
+}
+
+static bool is_permutation(const std::vector<size_t>& order, size_t n)
+{
+    std::vector<char> seen(n, 0);
+    for (size_t v : order) {
+        if (v >= n || seen[v]) {
+            return false;
+        }
+        seen[v] = 1;
+    }
+    return order.size() == n;
+}
+
+TEST_CASE( "sparse reordering", "[sparse]" ) {
+    const size_t w = 20, h = 15, n = w * h;
+    auto grid = poisson_2d(w, h);
+    auto scrambled = gmat::permute(grid, shuffled(n));
+
+    SECTION( "envelope" ) {
+        gmat::envelope e = gmat::measure_envelope(grid);
+        REQUIRE( e.bandwidth == w );
+        // Every row but the first w reaches back w columns, the rest of the first row 1.
+        REQUIRE( e.profile == (n - w) * w + (w - 1) );
+    }
+
+    SECTION( "permutation round trip" ) {
+        auto order = shuffled(n);
+        auto p = gmat::permute(grid, order);
+        REQUIRE( p.nnz() == grid.nnz() );
+        for (size_t k = 0; k < n; ++k) {
+            for (size_t l = 0; l < n; ++l) {
+                REQUIRE( p.get(k, l) == grid.get(order[k], order[l]) );
+            }
+        }
+        auto b = rhs(n);
+        auto back = gmat::unpermute_rows(gmat::permute_rows(b, order), order);
+        for (size_t i = 0; i < n; ++i) {
+            REQUIRE( back[i] == b[i] );
+        }
+        auto position = gmat::invert_order(order);
+        for (size_t k = 0; k < n; ++k) {
+            REQUIRE( position[order[k]] == k );
+        }
+    }
+
+    SECTION( "reverse Cuthill-McKee" ) {
+        auto order = gmat::reverse_cuthill_mckee(scrambled);
+        REQUIRE( is_permutation(order, n) );
+        gmat::envelope before = gmat::measure_envelope(scrambled);
+        gmat::envelope after = gmat::measure_envelope(gmat::permute(scrambled, order));
+        // Diagonal levels of a grid are at most min(w, h) wide.
+        REQUIRE( after.bandwidth <= h + 1 );
+        REQUIRE( after.profile * 5 < before.profile );
+    }
+
+    SECTION( "partition ordering" ) {
+        auto order = gmat::partition_order(scrambled, 16);
+        REQUIRE( is_permutation(order, n) );
+        gmat::envelope before = gmat::measure_envelope(scrambled);
+        gmat::envelope after = gmat::measure_envelope(gmat::permute(scrambled, order));
+        REQUIRE( after.profile * 4 < before.profile );
+    }
+
+    SECTION( "disconnected graph" ) {
+        gmat::coo_builder<double> coo(7, 7);
+        for (size_t i = 0; i < 7; ++i) {
+            coo.add(i, i, 4.0);
+        }
+        for (size_t i : { 0, 2, 4 }) {
+            coo.add(i, i + 2, -1.0);
+            coo.add(i + 2, i, -1.0);
+        }
+        auto a = coo.build();
+        REQUIRE( is_permutation(gmat::reverse_cuthill_mckee(a), 7) );
+        REQUIRE( is_permutation(gmat::partition_order(a, 2), 7) );
+    }
+}
+
+TEST_CASE( "reordered solver", "[solver]" ) {
+    const size_t w = 16, h = 12, n = w * h;
+    auto a = gmat::permute(poisson_2d(w, h), shuffled(n));
+    auto b = rhs(n);
+    auto x = direct_solve(a, b);
+    gabp::options<double> opts;
+    opts.tolerance = 1e-11;
+    opts.max_iterations = 500;
+    gabp::solver<double> plain(a, opts);
+    REQUIRE_FALSE( plain.solve(b) );
+
+    for (gabp::ordering how : { gabp::ordering::natural, gabp::ordering::rcm, gabp::ordering::partition }) {
+        gabp::reordered_solver<double> s(a, how, opts);
+        REQUIRE_FALSE( s.solve(b) );
+        // Synchronous sweeps do not depend on the numbering.
+        REQUIRE( s.iterations() == plain.iterations() );
+        for (size_t i = 0; i < n; ++i) {
+            REQUIRE( s.mean()[i] == Approx(x[i]).margin(1e-9) );
+            REQUIRE( s.precision()[i] == Approx(plain.precision()[i]) );
+        }
+        if (how == gabp::ordering::natural) {
+            REQUIRE( s.after().profile == s.before().profile );
+        } else {
+            REQUIRE( s.after().profile < s.before().profile );
+        }
+
+        auto b2 = b.clone();
+        b2[5] += 1.0;
+        REQUIRE_FALSE( s.resolve(b2) );
+        auto x2 = direct_solve(a, b2);
+        for (size_t i = 0; i < n; ++i) {
+            REQUIRE( s.mean()[i] == Approx(x2[i]).margin(1e-9) );
+        }
+    }
+}
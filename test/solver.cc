@@ -0,0 +1,354 @@
+#include "catch.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include "gabp/solver.hh"
+#include "problems.hh"
+
+TEST_CASE( "scalar gabp on a tree", "[solver]" ) {
+    auto a = chain(12);
+    auto b = rhs(12);
+    gabp::solver<double> s(a);
+    REQUIRE_FALSE( s.solve(b) );
+
+    auto x = direct_solve(a, b);
+    gmat::dynmatrix<double> inv;
+    gmat::inverse(densify(a), inv);
+    for (size_t i = 0; i < 12; ++i) {
+        REQUIRE( s.mean()[i] == Approx(x[i]).margin(1e-5) );
+        REQUIRE( s.precision()[i] == Approx(1.0 / inv.get(i, i)) );
+    }
+}
+
+TEST_CASE( "scalar gabp on a loopy grid", "[solver]" ) {
+    auto a = poisson_2d(8, 6);
+    auto b = rhs(48);
+    gabp::options<double> opts;
+    opts.tolerance = 1e-10;
+    opts.max_iterations = 500;
+    gabp::solver<double> s(a, opts);
+    REQUIRE_FALSE( s.solve(b) );
+    REQUIRE( s.residual() < 1e-10 );
+
+    auto x = direct_solve(a, b);
+    for (size_t i = 0; i < 48; ++i) {
+        REQUIRE( s.mean()[i] == Approx(x[i]).margin(1e-8) );
+    }
+
+    SECTION( "iteration limit" ) {
+        opts.max_iterations = 3;
+        gabp::solver<double> limited(a, opts);
+        REQUIRE( limited.solve(b) );
+        REQUIRE( limited.iterations() == 3 );
+    }
+}
+
+TEST_CASE( "residual scheduled gabp", "[solver]" ) {
+    auto a = poisson_2d(12, 10);
+    auto b = rhs(120);
+    auto x = direct_solve(a, b);
+    gabp::options<double> opts;
+    opts.tolerance = 1e-9;
+    opts.max_iterations = 500;
+
+    gabp::solver<double> sync(a, opts);
+    REQUIRE_FALSE( sync.solve(b) );
+    REQUIRE( sync.updates() == sync.iterations() * (a.nnz() - 120) );
+
+    opts.policy = gabp::schedule::residual;
+    gabp::solver<double> s(a, opts);
+    REQUIRE_FALSE( s.solve(b) );
+    REQUIRE( s.residual() < 1e-9 );
+    REQUIRE( s.updates() < sync.updates() );
+    for (size_t i = 0; i < 120; ++i) {
+        REQUIRE( s.mean()[i] == Approx(x[i]).margin(1e-7) );
+    }
+
+    SECTION( "exact on a tree" ) {
+        auto c = chain(12);
+        auto cb = rhs(12);
+        gabp::solver<double> t(c, opts);
+        REQUIRE_FALSE( t.solve(cb) );
+        auto cx = direct_solve(c, cb);
+        for (size_t i = 0; i < 12; ++i) {
+            REQUIRE( t.mean()[i] == Approx(cx[i]).margin(1e-8) );
+        }
+    }
+
+    SECTION( "update budget" ) {
+        opts.max_iterations = 1;
+        gabp::solver<double> limited(a, opts);
+        REQUIRE( limited.solve(b) );
+        REQUIRE( limited.iterations() == 1 );
+        REQUIRE( limited.residual() >= 1e-9 );
+    }
+}
+
+TEST_CASE( "multi-threaded gabp", "[solver]" ) {
+    auto a = poisson_2d(20, 15);
+    auto b = rhs(300);
+    gabp::options<double> opts;
+    opts.tolerance = 1e-10;
+    opts.max_iterations = 500;
+    gabp::solver<double> serial(a, opts);
+    REQUIRE_FALSE( serial.solve(b) );
+
+    for (size_t threads : {2, 3, 4, 7}) {
+        opts.threads = threads;
+        gabp::solver<double> s(a, opts);
+        REQUIRE_FALSE( s.solve(b) );
+        REQUIRE( s.iterations() == serial.iterations() );
+        REQUIRE( s.updates() == serial.updates() );
+        REQUIRE( s.residual() == serial.residual() );
+        for (size_t i = 0; i < 300; ++i) {
+            REQUIRE( s.mean()[i] == serial.mean()[i] );
+            REQUIRE( s.precision()[i] == serial.precision()[i] );
+        }
+    }
+
+    SECTION( "iteration limit" ) {
+        opts.threads = 4;
+        opts.max_iterations = 3;
+        gabp::solver<double> limited(a, opts);
+        REQUIRE( limited.solve(b) );
+        REQUIRE( limited.iterations() == 3 );
+    }
+
+    SECTION( "partition" ) {
+        auto bounds = gabp::detail::partition(a.offsets(), 300, 4);
+        REQUIRE( bounds.size() == 5 );
+        REQUIRE( bounds.front() == 0 );
+        REQUIRE( bounds.back() == 300 );
+        for (size_t t = 0; t < 4; ++t) {
+            size_t work = a.offsets()[bounds[t + 1]] - a.offsets()[bounds[t]];
+            REQUIRE( work > a.nnz() / 4 - 10 );
+            REQUIRE( work < a.nnz() / 4 + 10 );
+        }
+    }
+}
+
+TEST_CASE( "work-stealing gabp", "[solver]" ) {
+    auto a = poisson_2d(20, 15);
+    auto b = rhs(300);
+    auto x = direct_solve(a, b);
+    gabp::options<double> opts;
+    opts.policy = gabp::schedule::work_stealing;
+    opts.tolerance = 1e-11;
+    opts.max_iterations = 500;
+
+    for (size_t threads : {1, 2, 4}) {
+        opts.threads = threads;
+        gabp::solver<double> s(a, opts);
+        REQUIRE_FALSE( s.solve(b) );
+        REQUIRE( s.residual() < 1e-9 );
+        REQUIRE( s.updates() > 0 );
+        for (size_t i = 0; i < 300; ++i) {
+            REQUIRE( s.mean()[i] == Approx(x[i]).margin(1e-8) );
+        }
+    }
+
+    SECTION( "update budget" ) {
+        opts.threads = 2;
+        opts.max_iterations = 1;
+        gabp::solver<double> limited(a, opts);
+        REQUIRE( limited.solve(b) );
+        REQUIRE( limited.iterations() == 1 );
+    }
+
+    SECTION( "scheduler runs every item exclusively" ) {
+        const size_t items = 500;
+        gabp::detail::work_stealing pool(4, items);
+        std::vector<std::atomic<int>> running(items);
+        std::atomic<size_t> runs(0);
+        std::atomic<bool> overlap(false);
+        for (size_t k = 0; k < items; k += 50) {
+            pool.schedule(0, k);
+        }
+        pool.run([&](size_t w, size_t k) {
+            if (running[k].fetch_add(1) != 0) {
+                overlap = true;
+            }
+            if (runs.fetch_add(1) < 20000) {
+                pool.schedule(w, (k * 7 + 1) % items);
+                pool.schedule(w, (k * 13 + 5) % items);
+            }
+            running[k].fetch_sub(1);
+        });
+        REQUIRE_FALSE( overlap );
+        REQUIRE( runs >= 20000 );
+        REQUIRE_FALSE( pool.stopped() );
+    }
+}
+
+TEST_CASE( "warm-started gabp re-solve", "[solver]" ) {
+    auto a = poisson_2d(30, 20);
+    auto b = rhs(600);
+    gabp::options<double> opts;
+    opts.tolerance = 1e-12;
+    opts.max_iterations = 500;
+    gabp::solver<double> s(a, opts);
+
+    SECTION( "falls back to a full solve" ) {
+        REQUIRE_FALSE( s.resolve(b) );
+        REQUIRE( s.iterations() > 10 );
+    }
+
+    REQUIRE_FALSE( s.solve(b) );
+    size_t full = s.updates();
+
+    SECTION( "unchanged right-hand side" ) {
+        REQUIRE_FALSE( s.resolve(b) );
+        REQUIRE( s.updates() == 0 );
+    }
+
+    SECTION( "local change" ) {
+        auto b2 = b.clone();
+        b2[0] += 1.0;
+        b2[599] -= 0.5;
+        REQUIRE_FALSE( s.resolve(b2) );
+        REQUIRE( s.updates() < full );
+        auto x = direct_solve(a, b2);
+        for (size_t i = 0; i < 600; ++i) {
+            REQUIRE( s.mean()[i] == Approx(x[i]).margin(1e-9) );
+        }
+    }
+
+    SECTION( "streaming changes" ) {
+        auto b2 = b.clone();
+        for (size_t step = 0; step < 5; ++step) {
+            b2[(step * 137) % 600] += 0.25;
+            REQUIRE_FALSE( s.resolve(b2) );
+        }
+        auto x = direct_solve(a, b2);
+        for (size_t i = 0; i < 600; ++i) {
+            REQUIRE( s.mean()[i] == Approx(x[i]).margin(1e-9) );
+        }
+
+        gabp::solver<double> fresh(a, opts);
+        REQUIRE_FALSE( fresh.solve(b2) );
+        for (size_t i = 0; i < 600; ++i) {
+            REQUIRE( s.precision()[i] == Approx(fresh.precision()[i]) );
+        }
+    }
+}
+
+TEST_CASE( "batched right-hand sides", "[solver]" ) {
+    auto a = poisson_2d(12, 9);
+    const size_t n = 108, k = 7;
+    gmat::dynmatrix<double> b(n, k);
+    for (size_t c = 0; c < k; ++c) {
+        auto col = rhs(n, c + 1);
+        for (size_t i = 0; i < n; ++i) {
+            b.set(i, c, col[i]);
+        }
+    }
+    gabp::options<double> opts;
+    opts.tolerance = 1e-11;
+    opts.max_iterations = 500;
+    gabp::solver<double> s(a, opts);
+    REQUIRE_FALSE( s.solve_batch(b) );
+    REQUIRE( s.mean().rows() == n );
+    REQUIRE( s.mean().cols() == k );
+    size_t batched = s.iterations();
+
+    size_t slowest = 0;
+    for (size_t c = 0; c < k; ++c) {
+        auto col = rhs(n, c + 1);
+        auto x = direct_solve(a, col);
+        gabp::solver<double> single(a, opts);
+        REQUIRE_FALSE( single.solve(col) );
+        slowest = std::max(slowest, single.iterations());
+        for (size_t i = 0; i < n; ++i) {
+            REQUIRE( s.mean().get(i, c) == Approx(x[i]).margin(1e-9) );
+            REQUIRE( s.precision()[i] == Approx(single.precision()[i]) );
+        }
+    }
+    // Sweeps are the same as for one column; the batch stops with the slowest.
+    REQUIRE( batched == slowest );
+
+    SECTION( "single solve afterwards" ) {
+        auto col = rhs(n, 3);
+        REQUIRE_FALSE( s.resolve(col) );
+        REQUIRE( s.mean().cols() == 1 );
+        auto x = direct_solve(a, col);
+        for (size_t i = 0; i < n; ++i) {
+            REQUIRE( s.mean()[i] == Approx(x[i]).margin(1e-9) );
+        }
+    }
+}
+
+TEST_CASE( "accelerated synchronous sweeps", "[solver]" ) {
+    auto a = poisson_2d(15, 12, 0.02);
+    auto b = rhs(180);
+    auto x = direct_solve(a, b);
+    gabp::options<double> opts;
+    opts.tolerance = 1e-10;
+    opts.max_iterations = 5000;
+    gabp::solver<double> plain(a, opts);
+    REQUIRE_FALSE( plain.solve(b) );
+
+    for (gabp::acceleration how : { gabp::acceleration::aitken, gabp::acceleration::anderson }) {
+        for (size_t threads : { 1, 3 }) {
+            opts.accelerate = how;
+            opts.threads = threads;
+            gabp::solver<double> s(a, opts);
+            REQUIRE_FALSE( s.solve(b) );
+            REQUIRE( s.iterations() < plain.iterations() );
+            for (size_t i = 0; i < 180; ++i) {
+                REQUIRE( s.mean()[i] == Approx(x[i]).margin(1e-8) );
+            }
+        }
+    }
+}
+
+TEST_CASE( "accelerator", "[solver]" ) {
+    SECTION( "Anderson solves a linear iteration in a few steps" ) {
+        // x <- M x + c with a rotating contraction M; the fixed point is (1, 2).
+        // Plain steps would take about 40 to get within 1e-9.
+        gabp::accelerator<double> acc(gabp::acceleration::anderson, 2, 3, 1);
+        double v[2] = { 0.0, 0.0 };
+        for (size_t step = 0; step < 6; ++step) {
+            double x0 = v[0] - 1.0, x1 = v[1] - 2.0;
+            v[0] = 1.0 + 0.6 * x0 - 0.7 * x1;
+            v[1] = 2.0 + 0.7 * x0 + 0.6 * x1;
+            acc.apply(v);
+        }
+        REQUIRE( v[0] == Approx(1.0).margin(1e-9) );
+        REQUIRE( v[1] == Approx(2.0).margin(1e-9) );
+        REQUIRE( acc.extrapolations() > 0 );
+    }
+
+    SECTION( "Aitken extrapolates a geometric sequence" ) {
+        gabp::accelerator<double> acc(gabp::acceleration::aitken, 1, 1, 1);
+        double v = 1.0;
+        REQUIRE_FALSE( acc.apply(&v) );
+        v = 1.5;
+        REQUIRE( acc.apply(&v) );
+        REQUIRE( v == Approx(2.0) );
+
+        SECTION( "safeguard undoes an extrapolation that made things worse" ) {
+            v = 10.0;
+            REQUIRE( acc.apply(&v) );
+            REQUIRE( v == 1.5 );
+            REQUIRE( acc.rejected() == 1 );
+        }
+    }
+
+    SECTION( "interval" ) {
+        gabp::accelerator<double> acc(gabp::acceleration::aitken, 1, 1, 2);
+        double v = 0.0;
+        const double steps[] = { 1.0, 1.5, 1.75, 1.875 };
+        bool changed[4];
+        for (size_t k = 0; k < 4; ++k) {
+            v = steps[k];
+            changed[k] = acc.apply(&v);
+        }
+        REQUIRE_FALSE( changed[0] );
+        REQUIRE_FALSE( changed[1] );
+        REQUIRE_FALSE( changed[2] );
+        REQUIRE( changed[3] );
+        REQUIRE( v == Approx(2.0) );
+    }
+}
@@ -0,0 +1,84 @@
+#include "catch.hh"
+
+#include "gabp/sparse.hh"
+
+static gmat::coo_builder<double> example_triplets()
+{
+    // [ 4 -1  0  0 ]
+    // [-1  4 -1  0 ]
+    // [ 0 -1  4  2 ]
+    // [ 0  0  0  3 ]
+    gmat::coo_builder<double> coo(4, 4);
+    coo.add(3, 3, 3.0);
+    coo.add(2, 3, 2.0);
+    coo.add(0, 0, 4.0);
+    coo.add(1, 0, -1.0);
+    coo.add(2, 2, 1.5);
+    coo.add(1, 2, -1.0);
+    coo.add(0, 1, -1.0);
+    coo.add(2, 1, -1.0);
+    coo.add(1, 1, 4.0);
+    coo.add(2, 2, 2.5);
+    return coo;
+}
+
+TEST_CASE( "sparse construction", "[sparse]" ) {
+    auto coo = example_triplets();
+
+    SECTION( "compressed sparse rows" ) {
+        auto a = coo.build();
+        REQUIRE( a.rows() == 4 );
+        REQUIRE( a.nnz() == 9 );
+        REQUIRE( a.get(2, 2) == 4.0 );
+        REQUIRE( a.get(2, 3) == 2.0 );
+        REQUIRE( a.get(3, 2) == 0.0 );
+
+        size_t expected[] = { 1, 2, 3 };
+        size_t k = 0;
+        for (auto e : a.neighbors(2)) {
+            REQUIRE( e.index == expected[k++] );
+        }
+        REQUIRE( k == 3 );
+    }
+
+    SECTION( "compressed sparse columns" ) {
+        auto a = coo.build<gmat::sparse_layout::csc>();
+        REQUIRE( a.outer_size() == 4 );
+        REQUIRE( a.get(2, 3) == 2.0 );
+        REQUIRE( a.neighbors(3).size() == 2 );
+        REQUIRE( a.neighbors(3).entry(0).index == 2 );
+
+        auto b = a.convert();
+        auto c = coo.build();
+        REQUIRE( b.nnz() == c.nnz() );
+        for (size_t p = 0; p < c.nnz(); ++p) {
+            REQUIRE( b.indices()[p] == c.indices()[p] );
+            REQUIRE( b.values()[p] == c.values()[p] );
+        }
+    }
+}
+
+TEST_CASE( "sparse matrix-vector products", "[sparse]" ) {
+    auto coo = example_triplets();
+    gmat::dynmatrix<double> x(4, 1);
+    x[0] = 1;
+    x[1] = 2;
+    x[2] = 3;
+    x[3] = 4;
+    double ax[] = { 2, 4, 18, 12 };
+    double atx[] = { 2, 4, 10, 18 };
+
+    auto check = [&](const auto& a) {
+        gmat::dynmatrix<double> y;
+        gmat::spmv(a, x, y);
+        for (size_t i = 0; i < 4; ++i) {
+            REQUIRE( y[i] == ax[i] );
+        }
+        gmat::spmv_transpose(a, x, y);
+        for (size_t i = 0; i < 4; ++i) {
+            REQUIRE( y[i] == atx[i] );
+        }
+    };
+    check(coo.build<gmat::sparse_layout::csr>());
+    check(coo.build<gmat::sparse_layout::csc>());
+}
@@ -0,0 +1,176 @@
+#include "catch.hh"
+
+#include "gabp/symmatrix.hh"
+
+template <typename T, size_t n>
+static gmat::basematrix<T, n, n> spd_matrix()
+{
+    gmat::basematrix<T, n, n> a;
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            a.set(i, j, i == j ? T(n + 2) : T(1) / T(1 + i + j));
+        }
+    }
+    return a;
+}
+
+TEST_CASE( "symmatrix storage", "[symmatrix]" ) {
+    gmat::basematrix<double, 3, 3> a = spd_matrix<double, 3>();
+    a.set(2, 0, 100.0);
+    gmat::symmatrix<double, 3> s(a);
+    REQUIRE( sizeof(s) == 6 * sizeof(double) );
+    REQUIRE( s.data()[gmat::detail::packed_offset(3, 1) + 1] == a.get(1, 2) );
+
+    SECTION( "only the upper triangle is read" ) {
+        REQUIRE( s.get(2, 0) == a.get(0, 2) );
+        REQUIRE( s == gmat::symmetric(a) );
+    }
+
+    SECTION( "set writes the element shared with the mirror" ) {
+        s.set(2, 1, -1.0);
+        REQUIRE( s.get(1, 2) == -1.0 );
+        s.set(0, 2, -2.0);
+        REQUIRE( s.get(2, 0) == -2.0 );
+
+        // Walking the lower triangle column by column loses nothing.
+        gmat::symmatrix<double, 3> t(0.0);
+        for (size_t j = 0; j < 3; ++j) {
+            for (size_t i = j; i < 3; ++i) {
+                t.set(i, j, a.get(j, i));
+            }
+        }
+        REQUIRE( t == gmat::symmetric(a) );
+    }
+
+    SECTION( "entrywise algorithms update each element once" ) {
+        gmat::symmatrix<double, 3> t = s;
+        t += s;
+        t *= 0.5;
+        t -= s;
+        REQUIRE( t == gmat::symmatrix<double, 3>(0.0) );
+        t = s + s;
+        gmat::basematrix<double, 3, 3> dense = t;
+        REQUIRE( dense == gmat::symmetric(a) + gmat::symmetric(a) );
+
+        // Products accumulate through a temporary.
+        gmat::basematrix<double, 3, 3> sq = s * s;
+        gmat::matmul(s, s, t);
+        REQUIRE( t == gmat::symmetric(sq) );
+        gmat::gemm(2.0, s, s, -1.0, t);
+        REQUIRE( t == gmat::symmetric(sq) );
+    }
+}
+
+template <size_t n>
+static void check_packed_cholesky()
+{
+    gmat::basematrix<double, n, n> a = spd_matrix<double, n>();
+    gmat::symmatrix<double, n> chol(a);
+    REQUIRE_FALSE( gmat::cholesky(chol) );
+    gmat::basematrix<double, n, n> l = a;
+    REQUIRE_FALSE( gmat::cholesky(l) );
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = i; j < n; ++j) {
+            REQUIRE( chol.get(i, j) == Approx(l.get(j, i)) );
+        }
+    }
+
+    gmat::basematrix<double, n, 2> b;
+    for (size_t i = 0; i < n; ++i) {
+        b.set(i, 0, double(i) - 1.0);
+        b.set(i, 1, 1.0 / double(i + 1));
+    }
+    gmat::basematrix<double, n, 2> x = b;
+    gmat::cholesky_solve(chol, x);
+    gmat::basematrix<double, n, 2> ax = a * x;
+    for (size_t i = 0; i < n; ++i) {
+        REQUIRE( ax.get(i, 0) == Approx(b.get(i, 0)).margin(1e-12) );
+        REQUIRE( ax.get(i, 1) == Approx(b.get(i, 1)).margin(1e-12) );
+    }
+
+    // B^T A^-1 B from the forward half alone.
+    gmat::basematrix<double, n, 2> y = b;
+    gmat::cholesky_forward(chol, y);
+    gmat::symmatrix<double, 2> quad(1.0);
+    gmat::syrk(1.0, y, 0.0, quad);
+    gmat::basematrix<double, 2, 2> expected = gmat::transpose(b) * x;
+    REQUIRE( quad.get(0, 0) == Approx(expected.get(0, 0)) );
+    REQUIRE( quad.get(0, 1) == Approx(expected.get(0, 1)) );
+    REQUIRE( quad.get(1, 1) == Approx(expected.get(1, 1)) );
+}
+
+TEST_CASE( "packed cholesky factorization", "[symmatrix]" ) {
+    SECTION( "pose block" ) {
+        check_packed_cholesky<6>();
+    }
+
+    SECTION( "larger than a vector register" ) {
+        check_packed_cholesky<13>();
+    }
+
+    SECTION( "not positive definite" ) {
+        gmat::basematrix<double, 2, 2> a(1.0);
+        gmat::symmatrix<double, 2> s(a);
+        REQUIRE( gmat::cholesky(s) );
+    }
+
+    SECTION( "strided right-hand sides" ) {
+        gmat::basematrix<double, 3, 3> a = spd_matrix<double, 3>();
+        gmat::symmatrix<double, 3> chol(a);
+        REQUIRE_FALSE( gmat::cholesky(chol) );
+        double b[2][3] = {
+            {1, 2, 3},
+            {4, 5, 6}
+        };
+        gmat::matrix_view<double, 3, 1> col((double*) b, 1, 3);
+        gmat::cholesky_solve(chol, col);
+        gmat::basematrix<double, 3, 1> ax = a * col;
+        REQUIRE( ax.get(0, 0) == Approx(1.0) );
+        REQUIRE( ax.get(1, 0) == Approx(2.0) );
+        REQUIRE( ax.get(2, 0) == Approx(3.0) );
+        REQUIRE( b[1][0] == 4.0 );
+    }
+}
+
+TEST_CASE( "packed symmetric kernels", "[symmatrix]" ) {
+    gmat::basematrix<float, 9, 9> a = spd_matrix<float, 9>();
+    gmat::symmatrix<float, 9> s(a);
+    gmat::basematrix<float, 9, 1> x;
+    for (size_t i = 0; i < 9; ++i) {
+        x.set(i, 0, float(i % 4) - 1.5f);
+    }
+
+    SECTION( "matrix-vector product" ) {
+        gmat::basematrix<float, 9, 1> y(2.0f);
+        gmat::symv(0.5f, s, x, -1.0f, y);
+        gmat::basematrix<float, 9, 1> ax = a * x;
+        for (size_t i = 0; i < 9; ++i) {
+            REQUIRE( y.get(i, 0) == Approx(0.5f * ax.get(i, 0) - 2.0f) );
+        }
+        gmat::symv(1.0f, s, x, 0.0f, x);
+        for (size_t i = 0; i < 9; ++i) {
+            REQUIRE( x.get(i, 0) == Approx(ax.get(i, 0)) );
+        }
+    }
+
+    SECTION( "rank-k update" ) {
+        gmat::basematrix<float, 4, 9> b;
+        for (size_t p = 0; p < 4; ++p) {
+            for (size_t j = 0; j < 9; ++j) {
+                b.set(p, j, float((p * 5 + j * 3) % 7) - 3.0f);
+            }
+        }
+        gmat::symmatrix<float, 9> c = s;
+        gmat::syrk(-1.0f, b, 2.0f, c);
+        gmat::basematrix<float, 9, 9> btb = gmat::transpose(b) * b;
+        gmat::basematrix<float, 9, 4> bt = gmat::transpose(b);
+        gmat::symmatrix<float, 9> d(0.0f);
+        gmat::syrk(1.0f, gmat::transpose(bt), 0.0f, d);
+        for (size_t i = 0; i < 9; ++i) {
+            for (size_t j = 0; j < 9; ++j) {
+                REQUIRE( c.get(i, j) == Approx(2.0f * a.get(i, j) - btb.get(i, j)) );
+                REQUIRE( d.get(i, j) == Approx(btb.get(i, j)) );
+            }
+        }
+    }
+}